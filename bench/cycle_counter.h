@@ -0,0 +1,35 @@
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * Cheap cycle counter for the benchmarks
+ *
+ * x86: time stamp counter (constant rate on modern CPUs, close to nominal clock)
+ * ARMv8: generic timer (fixed frequency, see cntfrq_el0), not core cycles
+ *
+ */
+
+namespace CycleCounter {
+
+inline uint64_t now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t val;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(val));
+  return val;
+#else
+  return 0;
+#endif
+}
+
+} // namespace CycleCounter
+
+#endif // CYCLE_COUNTER_H
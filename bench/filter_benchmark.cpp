@@ -0,0 +1,546 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "kalman/ExtendedKalmanFilter.hpp"
+#include "drive_ros_localize_odom_fusion/CTRA_measurement_model.h"
+#include "drive_ros_localize_odom_fusion/CTRA_system_model.h"
+#include "drive_ros_localize_odom_fusion/CTRV_measurement_model.h"
+#include "drive_ros_localize_odom_fusion/CTRV_system_model.h"
+#include "drive_ros_localize_odom_fusion/CTRA_wrapper.h"
+#include "drive_ros_localize_odom_fusion/CTRV_wrapper.h"
+#include "drive_ros_localize_odom_fusion/batch_predict.h"
+#include "drive_ros_localize_odom_fusion/planar_ekf.h"
+#include "drive_ros_localize_odom_fusion/strand_pool.h"
+#include "cycle_counter.h"
+
+/*
+ * Microbenchmarks of the system models, Jacobians and EKF steps
+ *
+ * Every model benchmark runs with omega = 0 (straight line branch,
+ * |omega| < 0.01) and omega = 0.5 rad/s (turning branch) for float and double.
+ * Besides ns/op each benchmark reports "cycles" per iteration (see cycle_counter.h).
+ *
+ * The batch benchmarks predict state.range(0) filters with the same control
+ * input, once with ExtendedKalmanFilter::predict in a loop and once with the
+ * SIMD kernel of batch_predict.h (items/s = filters/s).
+ *
+ * The EKF benchmarks run with Kalman::ExtendedKalmanFilter and PlanarEKF
+ * (closed form filter for these models), the wrappers with the filter selected
+ * by ODOM_FUSION_PLANAR_EKF.
+ *
+ * The precision benchmarks run PlanarEKF and the wrappers in float, double
+ * and mixed precision (double state, float covariance). BM_Wrapper_drift
+ * drives state.range(0) predictions on a wide circle and reports the final
+ * deviation from the double wrapper ("drift_m", "drift_rad").
+ *
+ * The steady state heap allocations are checked by the unit tests
+ * (test/test_allocations.cpp).
+ *
+ * The pool benchmark runs many wrappers (vehicles) on one StrandPool with
+ * 1 and 4 threads (items/s = prediction steps/s of all vehicles).
+ *
+ */
+
+// expose the protected Jacobian update
+template<class SystemModel>
+class JacobianAccess : public SystemModel
+{
+public:
+  using SystemModel::updateJacobians;
+  using SystemModel::F;
+};
+
+// typical control inputs (10ms step at 1m/s)
+template<typename T>
+void setControl(CTRA::Control<T>& u, T omega)
+{
+  u.dt()    = T(0.01);
+  u.v()     = T(1.0);
+  u.a()     = T(0.5);
+  u.omega() = omega;
+}
+
+template<typename T>
+void setControl(CTRV::Control<T>& u, T omega)
+{
+  u.dt() = T(0.01);
+  u.v()  = T(1.0);
+  u.om() = omega;
+}
+
+// initial state
+template<class State>
+State initialState()
+{
+  State s;
+  s.x()     = 1;
+  s.y()     = 2;
+  s.theta() = 0.3;
+  return s;
+}
+
+// report cycles per iteration
+static void setCycles(benchmark::State& state, uint64_t cycles)
+{
+  state.counters["cycles"] = benchmark::Counter(static_cast<double>(cycles),
+                                                benchmark::Counter::kAvgIterations);
+}
+
+static float omegaFor(bool turning)
+{
+  return turning ? 0.5f : 0.0f;
+}
+
+
+// SystemModel::f
+template<class SystemModel, bool turning>
+static void BM_SystemModel_f(benchmark::State& state)
+{
+  typedef typename SystemModel::S S;
+  typedef typename SystemModel::C C;
+  typedef typename S::Scalar T;
+
+  SystemModel sys;
+  S x = initialState<S>();
+  C u;
+  setControl(u, T(omegaFor(turning)));
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(x);
+    S x_ = sys.f(x, u);
+    benchmark::DoNotOptimize(x_);
+  }
+  setCycles(state, CycleCounter::now() - start);
+}
+
+// SystemModel::updateJacobians
+template<class SystemModel, bool turning>
+static void BM_SystemModel_updateJacobians(benchmark::State& state)
+{
+  typedef typename SystemModel::S S;
+  typedef typename SystemModel::C C;
+  typedef typename S::Scalar T;
+
+  JacobianAccess<SystemModel> sys;
+  S x = initialState<S>();
+  C u;
+  setControl(u, T(omegaFor(turning)));
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(x);
+    sys.updateJacobians(x, u);
+    benchmark::DoNotOptimize(sys.F);
+  }
+  setCycles(state, CycleCounter::now() - start);
+}
+
+// ExtendedKalmanFilter::predict
+template<class SystemModel, bool turning,
+         template<class...> class Filter = Kalman::ExtendedKalmanFilter>
+static void BM_EKF_predict(benchmark::State& state)
+{
+  typedef typename SystemModel::S S;
+  typedef typename SystemModel::C C;
+  typedef typename S::Scalar T;
+
+  SystemModel sys;
+  sys.setCovariance(Kalman::Covariance<S>::Identity() * T(1e-3));
+  C u;
+  setControl(u, T(omegaFor(turning)));
+
+  Filter<S> filter;
+  filter.init(initialState<S>());
+  filter.setCovariance(Kalman::Covariance<S>::Identity() * T(1e-2));
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(filter.predict(sys, u));
+  }
+  setCycles(state, CycleCounter::now() - start);
+}
+
+// ExtendedKalmanFilter::update
+template<class MeasurementModel,
+         template<class...> class Filter = Kalman::ExtendedKalmanFilter>
+static void BM_EKF_update(benchmark::State& state)
+{
+  typedef typename MeasurementModel::S S;
+  typedef typename MeasurementModel::M M;
+  typedef typename S::Scalar T;
+
+  MeasurementModel mm;
+  mm.setCovariance(Kalman::Covariance<M>::Identity() * T(1e-2));
+  M z;
+  z << T(1.01), T(1.99), T(0.31);
+
+  Filter<S> filter;
+  filter.init(initialState<S>());
+  filter.setCovariance(Kalman::Covariance<S>::Identity() * T(1e-2));
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    benchmark::DoNotOptimize(filter.update(mm, z));
+  }
+  setCycles(state, CycleCounter::now() - start);
+}
+
+// full predict + update cycle as done by the wrappers
+template<class SystemModel, class MeasurementModel, bool turning,
+         template<class...> class Filter = Kalman::ExtendedKalmanFilter>
+static void BM_EKF_cycle(benchmark::State& state)
+{
+  typedef typename SystemModel::S S;
+  typedef typename SystemModel::C C;
+  typedef typename MeasurementModel::M M;
+  typedef typename S::Scalar T;
+
+  SystemModel sys;
+  sys.setCovariance(Kalman::Covariance<S>::Identity() * T(1e-3));
+  MeasurementModel mm;
+  mm.setCovariance(Kalman::Covariance<M>::Identity() * T(1e-2));
+  C u;
+  setControl(u, T(omegaFor(turning)));
+  M z;
+
+  Filter<S> filter;
+  filter.init(initialState<S>());
+  filter.setCovariance(Kalman::Covariance<S>::Identity() * T(1e-2));
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    const S& x = filter.predict(sys, u);
+    z = x;
+    benchmark::DoNotOptimize(filter.update(mm, z));
+  }
+  setCycles(state, CycleCounter::now() - start);
+}
+
+// ExtendedKalmanFilter::predict of many filters in a loop
+template<class SystemModel, bool turning>
+static void BM_EKF_predict_loop(benchmark::State& state)
+{
+  typedef typename SystemModel::S S;
+  typedef typename SystemModel::C C;
+  typedef typename S::Scalar T;
+
+  const size_t n = state.range(0);
+
+  SystemModel sys;
+  sys.setCovariance(Kalman::Covariance<S>::Identity() * T(1e-3));
+  C u;
+  setControl(u, T(omegaFor(turning)));
+
+  std::vector<Kalman::ExtendedKalmanFilter<S> > filters(n);
+  for(auto& filter : filters)
+  {
+    filter.init(initialState<S>());
+    filter.setCovariance(Kalman::Covariance<S>::Identity() * T(1e-2));
+  }
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    for(auto& filter : filters)
+    {
+      benchmark::DoNotOptimize(filter.predict(sys, u));
+    }
+  }
+  setCycles(state, CycleCounter::now() - start);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// the same with the structure of arrays kernel
+template<class SystemModel, bool turning>
+static void BM_Batch_predict(benchmark::State& state)
+{
+  typedef typename SystemModel::S S;
+  typedef typename SystemModel::C C;
+  typedef typename S::Scalar T;
+
+  const size_t n = state.range(0);
+
+  C u;
+  setControl(u, T(omegaFor(turning)));
+
+  BatchPredict::BatchState<T> batch(n);
+  for(size_t i = 0; i < n; i++)
+  {
+    batch.set(i, initialState<S>(),
+              Kalman::Covariance<S>::Identity() * T(1e-2),
+              Kalman::Covariance<S>::Identity() * T(1e-3));
+  }
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    BatchPredict::predict(batch, u);
+    benchmark::DoNotOptimize(batch.x.data());
+    benchmark::ClobberMemory();
+  }
+  setCycles(state, CycleCounter::now() - start);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// PlanarEKF with the covariance in the state precision and in float
+template<class State>
+using PlanarEKFMixed = PlanarEKF<State, float>;
+
+// wrapper prediction + correction over the core input structs
+template<class Wrapper, bool turning>
+static void BM_Wrapper_step(benchmark::State& state)
+{
+  Wrapper wrapper;
+  KalmanCov cov;
+  cov.filter_init_var_x = cov.filter_init_var_y = cov.filter_init_var_theta = 0.01;
+  cov.sys_var_x = cov.sys_var_y = cov.sys_var_theta = 0.001;
+  wrapper.setKalmanCov(cov);
+  wrapper.setTimeThreshold(0.5);
+  wrapper.reset();
+
+  ImuData imu;
+  imu.angular_velocity_z = omegaFor(turning);
+  imu.linear_acceleration_x = 0.5;
+
+  OdoData odo;
+  odo.linear_velocity_x = 1.0;
+  odo.pose_covariance[CovElem::lin_ang::linX_linX] = 0.01;
+  odo.pose_covariance[CovElem::lin_ang::linY_linY] = 0.01;
+  odo.pose_covariance[CovElem::lin_ang::angZ_angZ] = 0.01;
+
+  FilterOutput out;
+  double stamp = 1.0;
+
+  uint64_t start = CycleCounter::now();
+  for(auto _ : state)
+  {
+    stamp += 0.01;
+    odo.stamp = imu.stamp = stamp;
+    odo.position_x += 0.01;
+    wrapper.processPredictionData(stamp, &odo, &imu, out);
+    wrapper.processCorrectionData(stamp, &odo, &imu);
+    benchmark::DoNotOptimize(out);
+  }
+  setCycles(state, CycleCounter::now() - start);
+}
+
+// pose after a long prediction-only drive (10 m/s, 0.02 rad/s, 100 Hz)
+template<class Wrapper>
+static void drive(Wrapper& wrapper, const int steps, FilterOutput& out)
+{
+  KalmanCov cov;
+  cov.filter_init_var_x = cov.filter_init_var_y = cov.filter_init_var_theta = 0.01;
+  cov.sys_var_x = cov.sys_var_y = cov.sys_var_theta = 0.001;
+  wrapper.setKalmanCov(cov);
+  wrapper.setTimeThreshold(0.5);
+  wrapper.reset();
+
+  ImuData imu;
+  imu.angular_velocity_z = 0.02;
+
+  OdoData odo;
+  odo.linear_velocity_x = 10.0;
+
+  for(int k = 1; k <= steps; k++)
+  {
+    const double stamp = 1000.0 + 0.01*k;
+    odo.stamp = imu.stamp = stamp;
+    wrapper.processPredictionData(stamp, &odo, &imu, out);
+  }
+}
+
+// deviation of a precision from the double wrapper after the drive
+template<class Wrapper>
+static void BM_Wrapper_drift(benchmark::State& state)
+{
+  const int steps = state.range(0);
+
+  FilterWrapper<CTRAModelT<double> > reference;
+  FilterOutput ref;
+  drive(reference, steps, ref);
+
+  Wrapper wrapper;
+  FilterOutput out;
+  for(auto _ : state)
+  {
+    drive(wrapper, steps, out);
+    benchmark::DoNotOptimize(out);
+  }
+
+  state.counters["drift_m"]   = std::hypot(out.x - ref.x, out.y - ref.y);
+  state.counters["drift_rad"] = std::abs(out.theta - ref.theta);
+  state.SetItemsProcessed(state.iterations()*steps);
+}
+
+// many vehicles on one strand pool: every iteration queues 10 prediction
+// steps per vehicle (one task each) and waits until all ran. Args: vehicles,
+// threads (items/s = filter steps/s)
+template<class Wrapper>
+static void BM_Vehicles_pool(benchmark::State& state)
+{
+  const int vehicles = state.range(0);
+  StrandPool pool(state.range(1));
+
+  KalmanCov cov;
+  cov.filter_init_var_x = cov.filter_init_var_y = cov.filter_init_var_theta = 0.01;
+  cov.sys_var_x = cov.sys_var_y = cov.sys_var_theta = 0.001;
+
+  std::vector<std::unique_ptr<Wrapper> > wrappers;
+  std::vector<StrandPool::StrandPtr> strands;
+  std::vector<double> stamps(vehicles, 1.0);
+  for(int i = 0; i < vehicles; i++)
+  {
+    wrappers.emplace_back(new Wrapper);
+    wrappers.back()->setKalmanCov(cov);
+    wrappers.back()->setTimeThreshold(0.5);
+    wrappers.back()->reset();
+    strands.push_back(pool.createStrand());
+  }
+  pool.start();
+
+  std::atomic<int> done{0};
+  auto step = [&](const int i)
+  {
+    OdoData odo;
+    ImuData imu;
+    odo.linear_velocity_x = 1.0;
+    imu.angular_velocity_z = 0.5;
+    FilterOutput out;
+    for(int k = 0; k < 10; k++)
+    {
+      stamps[i] += 0.001;
+      wrappers[i]->processPredictionData(stamps[i], &odo, &imu, out);
+    }
+    done.fetch_add(1);
+  };
+
+  for(auto _ : state)
+  {
+    done.store(0);
+    for(int i = 0; i < vehicles; i++)
+    {
+      strands[i]->post([&step, i]{ step(i); });
+    }
+    while(done.load() < vehicles)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  pool.stop();
+  state.SetItemsProcessed(state.iterations()*vehicles*10);
+}
+
+
+// system models
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRA::SystemModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRA::SystemModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRA::SystemModel<double>, false);
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRA::SystemModel<double>, true);
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRV::SystemModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRV::SystemModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRV::SystemModel<double>, false);
+BENCHMARK_TEMPLATE(BM_SystemModel_f, CTRV::SystemModel<double>, true);
+
+// Jacobians
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRA::SystemModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRA::SystemModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRA::SystemModel<double>, false);
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRA::SystemModel<double>, true);
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRV::SystemModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRV::SystemModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRV::SystemModel<double>, false);
+BENCHMARK_TEMPLATE(BM_SystemModel_updateJacobians, CTRV::SystemModel<double>, true);
+
+// EKF steps
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<double>, false);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<double>, true);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRV::SystemModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRV::SystemModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRV::SystemModel<double>, false);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRV::SystemModel<double>, true);
+
+BENCHMARK_TEMPLATE(BM_EKF_update, CTRA::MeasurementModel<float>);
+BENCHMARK_TEMPLATE(BM_EKF_update, CTRA::MeasurementModel<double>);
+BENCHMARK_TEMPLATE(BM_EKF_update, CTRV::MeasurementModel<float>);
+BENCHMARK_TEMPLATE(BM_EKF_update, CTRV::MeasurementModel<double>);
+
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRA::SystemModel<float>,  CTRA::MeasurementModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRA::SystemModel<float>,  CTRA::MeasurementModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRA::SystemModel<double>, CTRA::MeasurementModel<double>, false);
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRA::SystemModel<double>, CTRA::MeasurementModel<double>, true);
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRV::SystemModel<float>,  CTRV::MeasurementModel<float>,  false);
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRV::SystemModel<float>,  CTRV::MeasurementModel<float>,  true);
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRV::SystemModel<double>, CTRV::MeasurementModel<double>, false);
+BENCHMARK_TEMPLATE(BM_EKF_cycle, CTRV::SystemModel<double>, CTRV::MeasurementModel<double>, true);
+
+// closed form filter
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<float>,  false, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<float>,  true,  PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRV::SystemModel<float>,  false, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRV::SystemModel<float>,  true,  PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_update,  CTRA::MeasurementModel<float>, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_update,  CTRV::MeasurementModel<float>, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_cycle,   CTRA::SystemModel<float>,  CTRA::MeasurementModel<float>,  true, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_cycle,   CTRV::SystemModel<float>,  CTRV::MeasurementModel<float>,  true, PlanarEKF);
+
+// closed form filter in double and mixed precision
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<double>, true, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_predict, CTRA::SystemModel<double>, true, PlanarEKFMixed);
+BENCHMARK_TEMPLATE(BM_EKF_update,  CTRA::MeasurementModel<double>, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_update,  CTRA::MeasurementModel<double>, PlanarEKFMixed);
+BENCHMARK_TEMPLATE(BM_EKF_cycle,   CTRA::SystemModel<double>, CTRA::MeasurementModel<double>, true, PlanarEKF);
+BENCHMARK_TEMPLATE(BM_EKF_cycle,   CTRA::SystemModel<double>, CTRA::MeasurementModel<double>, true, PlanarEKFMixed);
+
+// many filters, loop vs. batch kernel
+BENCHMARK_TEMPLATE(BM_EKF_predict_loop, CTRA::SystemModel<float>, true)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Batch_predict,    CTRA::SystemModel<float>, true)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_EKF_predict_loop, CTRV::SystemModel<float>, true)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Batch_predict,    CTRV::SystemModel<float>, true)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Batch_predict,    CTRA::SystemModel<float>, false)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Batch_predict,    CTRA::SystemModel<double>, true)->Arg(1024);
+
+// wrappers (ODOM_FUSION_PRECISION)
+BENCHMARK_TEMPLATE(BM_Wrapper_step, CTRAWrapper, false);
+BENCHMARK_TEMPLATE(BM_Wrapper_step, CTRAWrapper, true);
+BENCHMARK_TEMPLATE(BM_Wrapper_step, CTRVWrapper, false);
+BENCHMARK_TEMPLATE(BM_Wrapper_step, CTRVWrapper, true);
+
+// wrappers in float, double and mixed precision
+BENCHMARK_TEMPLATE(BM_Wrapper_step, FilterWrapper<CTRAModelT<float> >,         true);
+BENCHMARK_TEMPLATE(BM_Wrapper_step, FilterWrapper<CTRAModelT<double> >,        true);
+BENCHMARK_TEMPLATE(BM_Wrapper_step, FilterWrapper<CTRAModelT<double, float> >, true);
+
+// drift of long drives (arg: predictions)
+BENCHMARK_TEMPLATE(BM_Wrapper_drift, FilterWrapper<CTRAModelT<float> >)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Wrapper_drift, FilterWrapper<CTRAModelT<double> >)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Wrapper_drift, FilterWrapper<CTRAModelT<double, float> >)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// vehicles on a shared thread pool (args: vehicles, threads)
+BENCHMARK_TEMPLATE(BM_Vehicles_pool, CTRAWrapper)->Args({32, 1})->Args({32, 4})->UseRealTime();
+
+int main(int argc, char** argv)
+{
+  // keep the wrapper benchmarks quiet
+  FusionLog::setLevel(FusionLog::Warn);
+
+  benchmark::Initialize(&argc, argv);
+  if(benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
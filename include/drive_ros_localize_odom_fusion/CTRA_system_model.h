@@ -2,6 +2,7 @@
 #define CTRA_SYSTEM_MODEL_H
 
 #include <kalman/LinearizedSystemModel.hpp>
+#include "model_utils.h"
 
 namespace CTRA {
 
@@ -101,32 +102,75 @@ public:
      * @returns The (predicted) system state in the next time-step
      */
     S f(const S& x, const C& u) const
+    {
+        T x_theta, y_theta;
+        return transition(x, u, x_theta, y_theta);
+    }
+
+    /**
+     * @brief Non-trivial entries of the Jacobian of f
+     *
+     * F is the identity except for F(X,THETA) and F(Y,THETA), which are
+     * returned here (used by PlanarEKF without building F).
+     *
+     * @param [in] x The system state in current time-step
+     * @param [in] u The control vector input
+     * @param [out] x_theta F(X,THETA)
+     * @param [out] y_theta F(Y,THETA)
+     */
+    void jacobianTheta( const S& x, const C& u, T& x_theta, T& y_theta ) const
+    {
+        transition(x, u, x_theta, y_theta);
+    }
+
+    /**
+     * @brief State transition f and its Jacobian in one pass
+     *
+     * Evaluates sine and cosine of each angle once (in the precision of T)
+     * and shares them between f and F.
+     *
+     * @param [in] x The system state in current time-step
+     * @param [in] u The control vector input
+     * @param [out] x_theta F(X,THETA)
+     * @param [out] y_theta F(Y,THETA)
+     * @returns The (predicted) system state in the next time-step
+     */
+    S transition( const S& x, const C& u, T& x_theta, T& y_theta ) const
     {
         //! Predicted state vector after transition
         S x_;
 
-        auto th = x.theta();
-        auto v  = u.v();
-        auto a  = u.a();
-        auto om = u.omega();
-        auto dT = u.dt();
-
+        T th = x.theta();
+        T v  = u.v();
+        T a  = u.a();
+        T om = u.omega();
+        T dT = u.dt();
 
-        auto cosTh = std::cos(th);
-        auto sinTh = std::sin(th);
+        T sinTh, cosTh;
+        ModelUtils::sincos(th, sinTh, cosTh);
 
         if (std::abs(om) < T(0.01))
         {
-            x_.x() = x.x() + T(0.5)*dT*(2*v+a*dT)*cosTh;
-            x_.y() = x.y() + T(0.5)*dT*(2*v+a*dT)*sinTh;
+            T pTheta = T(0.5)*dT*(2*v+a*dT);
+
+            x_.x() = x.x() + pTheta*cosTh;
+            x_.y() = x.y() + pTheta*sinTh;
+
+            x_theta = pTheta * -sinTh;
+            y_theta = pTheta * cosTh;
         }
         else
         {
-            auto cosThOmT = std::cos(th + om*dT);
-            auto sinThOmT = std::sin(th + om*dT);
+            T sinThOmT, cosThOmT;
+            ModelUtils::sincos(th + om*dT, sinThOmT, cosThOmT);
+
+            T omSqrInv = 1/(om*om);
 
-            x_.x() = x.x() + 1/(om*om)*((v*om+a*om*dT)*sinThOmT + a*cosThOmT - v*om*sinTh - a*cosTh);
-            x_.y() = x.y() + 1/(om*om)*((-v*om-a*om*dT)*cosThOmT + a*sinThOmT + v*om*cosTh - a*sinTh);
+            x_.x() = x.x() + omSqrInv*((v*om+a*om*dT)*sinThOmT + a*cosThOmT - v*om*sinTh - a*cosTh);
+            x_.y() = x.y() + omSqrInv*((-v*om-a*om*dT)*cosThOmT + a*sinThOmT + v*om*cosTh - a*sinTh);
+
+            x_theta = omSqrInv * ( a*om*dT*cosThOmT + v*om*(cosThOmT-cosTh) - a*(sinThOmT-sinTh) );
+            y_theta = omSqrInv * ( a*om*dT*sinThOmT + v*om*(sinThOmT-sinTh) + a*(cosThOmT-cosTh) );
         }
 
         x_.theta() = x.theta() + om*dT;
@@ -138,33 +182,7 @@ protected:
     void updateJacobians( const S& x, const C& u )
     {
         this->F.setIdentity();
-
-        auto th = x.theta();
-        auto v  = u.v();
-        auto a  = u.a();
-        auto om = u.omega();
-        auto dT = u.dt();
-
-        auto cosTh = std::cos(th);
-        auto sinTh = std::sin(th);
-
-        if (std::abs(om) < T(0.01))
-        {
-            auto pTheta = T(0.5)*dT*(2*v+a*dT);
-
-            this->F( S::X, S::THETA ) = pTheta * -sinTh;
-            this->F( S::Y, S::THETA ) = pTheta * cosTh;
-        }
-        else
-        {
-            auto cosThOmT = std::cos(th + om*dT);
-            auto sinThOmT = std::sin(th + om*dT);
-
-            auto omSqrInv = 1/(om*om);
-
-            this->F( S::X, S::THETA ) = omSqrInv * ( a*om*dT*cosThOmT + v*om*(cosThOmT-cosTh) - a*(sinThOmT-sinTh) );
-            this->F( S::Y, S::THETA ) = omSqrInv * ( a*om*dT*sinThOmT + v*om*(sinThOmT-sinTh) + a*(cosThOmT-cosTh) );
-        }
+        jacobianTheta(x, u, this->F( S::X, S::THETA ), this->F( S::Y, S::THETA ));
     }
 };
 
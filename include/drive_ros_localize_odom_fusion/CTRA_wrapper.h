@@ -1,65 +1,41 @@
 #ifndef CTRA_WRAPPER_H
 #define CTRA_WRAPPER_H
 
-#include "kalman/ExtendedKalmanFilter.hpp"
-#include "base_wrapper.h"
+#include "filter_wrapper.h"
+#include "fusion_precision.h"
+#include "planar_ekf.h"
 #include "CTRA_measurement_model.h"
 #include "CTRA_system_model.h"
 
-// stupid clang compiler
-#ifndef M_PI
-#define M_PI (3.14159265358979323846)
-#endif
-
-class CTRAWrapper : public BaseWrapper
+// constant turn rate and acceleration model (IMU yaw rate and acceleration, odometry velocity),
+// state in T, covariance math in CovT (see fusion_precision.h)
+template<typename T, typename CovT = T>
+struct CTRAModelT
 {
-public:
-  typedef float T;
-
   typedef CTRA::State<T> State;
   typedef CTRA::Control<T> Control;
   typedef CTRA::Measurement<T> Measurement;
 
   typedef CTRA::MeasurementModel<T> MeasurementModel;
   typedef CTRA::SystemModel<T> SystemModel;
-  typedef Kalman::ExtendedKalmanFilter<State> Filter;
-
-
-  // constructor
-  CTRAWrapper(ros::NodeHandle& n, ros::NodeHandle& p);
-
-
-private:
-
-  // initialize Kalman Filter
-  bool initFilterState();
+  typedef PlanarFilter<State, CovT> Filter;
 
-  bool predict(const float,
-               const nav_msgs::OdometryConstPtr &odo_msg,
-               const sensor_msgs::ImuConstPtr &imu_msg);
+  static const char* name() { return "CTRA"; }
 
-  bool correct(const float,
-               const nav_msgs::OdometryConstPtr &odo_msg,
-               const sensor_msgs::ImuConstPtr &imu_msg);
-
-  bool getOutput(geometry_msgs::TransformStamped& tf_msg,
-                 nav_msgs::Odometry& odom_msg);
-
-
-  Control u;
-  Measurement z;
-  SystemModel sys;
-  MeasurementModel mm;
-  Filter filter;
-
-
-  Kalman::Covariance<Measurement> mm_cov;
-  Measurement odom_old;
-  Measurement state_old;
-  double yaw_old;
+  static void control(Control& u, const double dt, const OdoData& odo, const ImuData& imu);
+  static void measurementCovariance(Kalman::Covariance<Measurement>& cov, const OdoData& odo);
 };
 
-
-
+// all precisions compiled once in CTRA_wrapper.cpp
+extern template struct CTRAModelT<float>;
+extern template struct CTRAModelT<double>;
+extern template struct CTRAModelT<double, float>;
+extern template class FilterWrapper<CTRAModelT<float> >;
+extern template class FilterWrapper<CTRAModelT<double> >;
+extern template class FilterWrapper<CTRAModelT<double, float> >;
+
+// model of the node and the tools (ODOM_FUSION_PRECISION)
+typedef CTRAModelT<FusionScalar, FusionCovScalar> CTRAModel;
+typedef FilterWrapper<CTRAModel> CTRAWrapper;
 
 #endif
@@ -2,6 +2,7 @@
 #define CTRV_SYSTEM_MODEL_H
 
 #include <kalman/LinearizedSystemModel.hpp>
+#include "model_utils.h"
 
 namespace CTRV {
 
@@ -91,36 +92,89 @@ public:
      * @returns The (predicted) system state in the next time-step
      */
     S f(const S& s, const C& u) const
+    {
+        T x_theta, y_theta;
+        return transition(s, u, x_theta, y_theta);
+    }
+
+    /**
+     * @brief Non-trivial entries of the Jacobian of f
+     *
+     * F is the identity except for F(X,THETA) and F(Y,THETA), which are
+     * returned here (used by PlanarEKF without building F).
+     *
+     * @param [in] s The system state in current time-step
+     * @param [in] u The control vector input
+     * @param [out] x_theta F(X,THETA)
+     * @param [out] y_theta F(Y,THETA)
+     */
+    void jacobianTheta( const S& s, const C& u, T& x_theta, T& y_theta ) const
+    {
+        transition(s, u, x_theta, y_theta);
+    }
+
+    /**
+     * @brief State transition f and its Jacobian in one pass
+     *
+     * Evaluates sine and cosine of each angle once (in the precision of T)
+     * and shares them between f and F.
+     *
+     * @param [in] s The system state in current time-step
+     * @param [in] u The control vector input
+     * @param [out] x_theta F(X,THETA)
+     * @param [out] y_theta F(Y,THETA)
+     * @returns The (predicted) system state in the next time-step
+     */
+    S transition( const S& s, const C& u, T& x_theta, T& y_theta ) const
     {
         //! Predicted state vector after transition
         S s_;
 
-        auto x = s.x();
-        auto y = s.y();
-        auto theta = s.theta();
-        auto v = u.v();
-        auto omega = u.om();
-        auto t = u.dt();
+        T x = s.x();
+        T y = s.y();
+        T theta = s.theta();
+        T v = u.v();
+        T omega = u.om();
+        T t = u.dt();
+
+        T sin_theta, cos_theta;
+        ModelUtils::sincos(theta, sin_theta, cos_theta);
 
         // simple model
         if (std::abs(omega) < T(0.01))
         {
 
           /* Matlab generated code (check the docs) for symbolic expression: f */
-          s_(0) = x+t*v*cos(theta);
-          s_(1) = y+t*v*sin(theta);
+          s_(0) = x+t*v*cos_theta;
+          s_(1) = y+t*v*sin_theta;
           s_(2) = theta;
 
+          /*
+          Matlab generated code (check the docs) for symbolic expression: FLimit
+          */
+          x_theta = -t*v*sin_theta;
+          y_theta = t*v*cos_theta;
+
         // standard model
         }else{
 
-            /* Matlab generated code (check the docs) for symbolic expression: fLimit */
-            auto t2 = 1.0/omega;
-            auto t3 = omega*t;
-            auto t4 = t3+theta;
-            s_(0) = x+t2*v*(sin(t4)-sin(theta));
-            s_(1) = y-t2*v*(cos(t4)-cos(theta));
-            s_(2) = t4;
+          /* Matlab generated code (check the docs) for symbolic expression: fLimit */
+          T t2 = T(1)/omega;
+          T t3 = omega*t;
+          T t4 = t3+theta;
+
+          T sin_t4, cos_t4;
+          ModelUtils::sincos(t4, sin_t4, cos_t4);
+
+          s_(0) = x+t2*v*(sin_t4-sin_theta);
+          s_(1) = y-t2*v*(cos_t4-cos_theta);
+          s_(2) = t4;
+
+          /*
+          Matlab generated code (check the docs) for symbolic expression: F
+          */
+          x_theta = t2*v*(cos_t4-cos_theta);
+          y_theta = t2*v*(sin_t4-sin_theta);
 
         }
 
@@ -131,41 +185,7 @@ protected:
     void updateJacobians( const S& s, const C& u )
     {
         this->F.setIdentity();
-
-        auto theta = s.theta();
-        auto v = u.v();
-        auto omega = u.om();
-        auto t = u.dt();
-
-        // simple model
-        if (std::abs(omega) < T(0.01))
-        {
-
-          /*
-          Matlab generated code (check the docs) for symbolic expression: FLimit
-          */
-          this->F(0,0) = 1.0;
-          this->F(0,2) = -t*v*sin(theta);
-          this->F(1,1) = 1.0;
-          this->F(1,2) = t*v*cos(theta);
-          this->F(2,2) = 1.0;
-
-        // standard model
-        }else{
-
-          /*
-          Matlab generated code (check the docs) for symbolic expression: F
-          */
-          auto t2 = 1.0/omega;
-          auto t3 = omega*t;
-          auto t4 = t3+theta;
-          this->F(0,0) = 1.0;
-          this->F(0,2) = t2*v*(cos(t4)-cos(theta));
-          this->F(1,1) = 1.0;
-          this->F(1,2) = t2*v*(sin(t4)-sin(theta));
-          this->F(2,2) = 1.0;
-
-        }
+        jacobianTheta(s, u, this->F(S::X, S::THETA), this->F(S::Y, S::THETA));
     }
 };
 
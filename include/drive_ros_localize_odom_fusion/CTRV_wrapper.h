@@ -1,66 +1,41 @@
 #ifndef CTRV_WRAPPER_H
 #define CTRV_WRAPPER_H
 
-#include "kalman/ExtendedKalmanFilter.hpp"
-#include "base_wrapper.h"
+#include "filter_wrapper.h"
+#include "fusion_precision.h"
+#include "planar_ekf.h"
 #include "CTRV_measurement_model.h"
 #include "CTRV_system_model.h"
-#include "drive_ros_localize_odom_fusion/moving_average.h"
-#include <cmath>
 
-// stupid clang compiler
-#ifndef M_PI
-#define M_PI (3.14159265358979323846)
-#endif
-
-class CTRVWrapper : public BaseWrapper
+// constant turn rate and velocity model (IMU yaw rate, odometry velocity),
+// state in T, covariance math in CovT (see fusion_precision.h)
+template<typename T, typename CovT = T>
+struct CTRVModelT
 {
-public:
-  typedef float T;
-
   typedef CTRV::State<T> State;
   typedef CTRV::Control<T> Control;
   typedef CTRV::Measurement<T> Measurement;
 
   typedef CTRV::MeasurementModel<T> MeasurementModel;
   typedef CTRV::SystemModel<T> SystemModel;
-  typedef Kalman::ExtendedKalmanFilter<State> Filter;
-
-
-  // constructor
-  CTRVWrapper(ros::NodeHandle& n, ros::NodeHandle& p);
-
-
-private:
-
-  // initialize Kalman Filter
-  bool initFilterState();
+  typedef PlanarFilter<State, CovT> Filter;
 
-  bool predict(const float,
-               const nav_msgs::OdometryConstPtr &odo_msg,
-               const sensor_msgs::ImuConstPtr &imu_msg);
-
-  bool correct(const float,
-               const nav_msgs::OdometryConstPtr &odo_msg,
-               const sensor_msgs::ImuConstPtr &imu_msg);
-
-  bool getOutput(geometry_msgs::TransformStamped& tf_msg,
-                 nav_msgs::Odometry& odom_msg);
-
-
-  Control u;
-  Measurement z;
-  SystemModel sys;
-  MeasurementModel mm;
-  Filter filter;
-
-  Measurement state_old;
-  Measurement odom_old;
-  double yaw_old;
+  static const char* name() { return "CTRV"; }
 
+  static void control(Control& u, const double dt, const OdoData& odo, const ImuData& imu);
+  static void measurementCovariance(Kalman::Covariance<Measurement>& cov, const OdoData& odo);
 };
 
-
-
+// all precisions compiled once in CTRV_wrapper.cpp
+extern template struct CTRVModelT<float>;
+extern template struct CTRVModelT<double>;
+extern template struct CTRVModelT<double, float>;
+extern template class FilterWrapper<CTRVModelT<float> >;
+extern template class FilterWrapper<CTRVModelT<double> >;
+extern template class FilterWrapper<CTRVModelT<double, float> >;
+
+// model of the node and the tools (ODOM_FUSION_PRECISION)
+typedef CTRVModelT<FusionScalar, FusionCovScalar> CTRVModel;
+typedef FilterWrapper<CTRVModel> CTRVWrapper;
 
 #endif
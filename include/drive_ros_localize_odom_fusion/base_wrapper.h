@@ -2,153 +2,239 @@
 #define BASE_MODEL_H
 
 // system
+#include <atomic>
+#include <cassert>
 #include <cmath>
+#include <memory>
 #include <mutex>
-#include <fstream>
-
-// ros
-#include <ros/ros.h>
-#include <tf/tf.h>
-#include <tf2_ros/transform_broadcaster.h>
-#include <tf2/LinearMath/Quaternion.h>
-#include <message_filters/subscriber.h>
-#include <message_filters/time_synchronizer.h>
-#include <message_filters/sync_policies/approximate_time.h>
-
-// ros messages
-#include <geometry_msgs/TransformStamped.h>
-#include <sensor_msgs/Imu.h>
-#include <nav_msgs/Odometry.h>
-
-// ros services
-#include <std_srvs/Trigger.h>
-
-// covariances
+#include <vector>
+
+// filter core (ROS independent)
 #include "cov_elements.h"
+#include "kalman_cov.h"
+#include "fusion_types.h"
+#include "fusion_log.h"
+#include "latency_stats.h"
+#include "rts_smoother.h"
 
 
-class BaseWrapper
+// complete mutable state of a wrapper (filter state, covariances and the
+// values kept between corrections), used to rewind the filter
+// (FilterWrapper checks at compile time that its model fits)
+struct WrapperState
 {
-public:
+  enum { CAPACITY = 32 };
+
+  double data[CAPACITY];
+  int size = 0;
+
+  // append all coefficients of a matrix/vector or a single value
+  template<class M>
+  void write(const M& m)
+  {
+    assert(size + m.size() <= CAPACITY);
+    for(int i = 0; i < m.size(); i++)
+      data[size++] = m.coeff(i);
+  }
+  void write(const double v)
+  {
+    assert(size < CAPACITY);
+    data[size++] = v;
+  }
+
+  // read them back in the same order
+  template<class M>
+  void read(M& m, int& pos) const
+  {
+    for(int i = 0; i < m.size(); i++)
+      m.coeffRef(i) = data[pos++];
+  }
+  void read(double& v, int& pos) const { v = data[pos++]; }
+};
 
-  // init publisher, subscriber and some parameters
-  bool initROS();
 
-  // some typedefs
-  typedef message_filters::sync_policies::ApproximateTime<nav_msgs::Odometry,
-                                                          sensor_msgs::Imu> SyncPolicy;
-protected:
+class BaseWrapper
+{
+public:
 
-  // initialize Kalman Filter
-  virtual bool initFilterState() = 0;
+  virtual ~BaseWrapper() {}
 
+  // set parameters
+  void setTimeThreshold(const double threshold);
 
-  // Kalman filter prediction
-  virtual bool predict(const float dt,
-                       const nav_msgs::OdometryConstPtr &odo_msg,
-                       const sensor_msgs::ImuConstPtr &imu_msg) = 0;
+  // validate and swap in a new covariance snapshot (any thread, never blocks
+  // the filter): the process noise applies from the next prediction, the
+  // initial variances from the next reset. Invalid values are rejected.
+  bool setKalmanCov(const KalmanCov& cov);
+  std::shared_ptr<const KalmanCov> getKalmanCov() const;
 
-  // Kalman filter correction
-  virtual bool correct(const float dt,
-                       const nav_msgs::OdometryConstPtr &odo_msg,
-                       const sensor_msgs::ImuConstPtr &imu_msg) = 0;
+  // disable the model mutex if only a single thread uses the model
+  void setLocking(const bool enabled);
 
-  // publish data
-  virtual bool getOutput(geometry_msgs::TransformStamped& tf_msg,
-                         nav_msgs::Odometry& odom_msg) = 0;
+  // keep the last steps to apply late samples at their true time (0 disables)
+  void setHistorySize(const size_t size);
 
+  // time the filter stages into stats (NULL disables timing, not owned)
+  void setLatencyStats(LatencyStats* stats);
 
-  // ros node handle
-  ros::NodeHandle nh;
-  ros::NodeHandle pnh;
+  // keep a copy of the newest state and control input for extrapolate()
+  void setExtrapolation(const bool enabled);
 
+  // record the filter steps for an offline smoother pass (NULL disables,
+  // not owned, requires history size 0)
+  void setSmoother(RtsSmoother* smoother);
 
- private:
   // reset filter and times
   bool reset();
 
-  // calculates the current/old timestamp/delta
-  bool processTimestamp(ros::Time& last_t, ros::Time& curr_t,
-                        ros::Duration& last_d, ros::Duration& curr_d) const;
+  // PREDICTION: process the prediction data (odo or imu may be NULL) and fill output
+  // (without output only out.stamp is set and getOutput is skipped). A late
+  // prediction (older than the history head) is applied at its time but returns
+  // false, the newest output did not change and out is not filled.
+  bool processPredictionData(double current_timestamp,
+                             const OdoData* odo,
+                             const ImuData* imu,
+                             FilterOutput& out,
+                             const bool output = true);
+
+  // CORRECTION: process the correction data (odo or imu may be NULL)
+  bool processCorrectionData(double current_timestamp,
+                             const OdoData* odo,
+                             const ImuData* imu);
+
+  // EXTRAPOLATION: predict a copy of the newest state to the timestamp with the
+  // last control input, the filter is not touched (may be called from any thread,
+  // false without a state newer than time_threshold)
+  bool extrapolate(double timestamp, FilterOutput& out);
 
-  // services
-  bool svrReset(std_srvs::Trigger::Request  &req,
-                std_srvs::Trigger::Response &res);
+protected:
 
-  // PREDICTION: process the prediction data
-  bool processPredictionData(ros::Time current_timestamp,
-                             const nav_msgs::OdometryConstPtr &msg_odo,
-                             const sensor_msgs::ImuConstPtr &msg_imu);
+  // initialize Kalman Filter
+  virtual bool initFilterState(const KalmanCov& cov) = 0;
 
-  // CORRECTION: process the correction data
-  bool processCorrectionData(ros::Time current_timestamp,
-                             const nav_msgs::OdometryConstPtr &msg_odo,
-                             const sensor_msgs::ImuConstPtr &msg_imu);
+  // set the process noise of the running filter
+  virtual bool setProcessNoise(const KalmanCov& cov) = 0;
 
 
-  // PREDICTION callback functions
-  void predSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,  // both available
-                        const sensor_msgs::ImuConstPtr &msg_imu);
-  void predOdoCallback (const nav_msgs::OdometryConstPtr &msg_odo); // only odo available
-  void predImuCallback (const sensor_msgs::ImuConstPtr &msg_imu);   // only imu available
+  // Kalman filter prediction
+  virtual bool predict(const double dt,
+                       const OdoData* odo,
+                       const ImuData* imu) = 0;
 
-  // CORRECTION callback functions
-  void corrSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,  // both available
-                        const sensor_msgs::ImuConstPtr &msg_imu);
-  void corrOdoCallback (const nav_msgs::OdometryConstPtr &msg_odo); // only odo available
-  void corrImuCallback (const sensor_msgs::ImuConstPtr &msg_imu);   // only imu available
+  // Kalman filter correction
+  virtual bool correct(const double dt,
+                       const OdoData* odo,
+                       const ImuData* imu) = 0;
 
+  // output data
+  virtual bool getOutput(FilterOutput& out) = 0;
 
-  // PREDICTION subscriber and message filter stuff
-  message_filters::Subscriber<sensor_msgs::Imu>   *pred_imu_sub;
-  message_filters::Subscriber<nav_msgs::Odometry> *pred_odo_sub;
-  message_filters::Synchronizer<SyncPolicy>       *pred_sync;
-  SyncPolicy                                      *pred_policy;
+  // save/restore everything predict and correct depend on
+  virtual void saveState(WrapperState& state) const = 0;
+  virtual void restoreState(const WrapperState& state) = 0;
 
-  // PREDICTION single subscriber
-  ros::Subscriber pred_imu_single_sub;
-  ros::Subscriber pred_odo_single_sub;
+  // copy state, covariances and control input for the extrapolation
+  virtual void saveSnapshot() = 0;
 
-  // CORRECTION subscriber and message filter stuffe
-  message_filters::Subscriber<sensor_msgs::Imu>   *corr_imu_sub;
-  message_filters::Subscriber<nav_msgs::Odometry> *corr_odo_sub;
-  message_filters::Synchronizer<SyncPolicy>       *corr_sync;
-  SyncPolicy                                      *corr_policy;
+  // predict the snapshot dt ahead and output it
+  virtual bool extrapolateSnapshot(const double dt, FilterOutput& out) = 0;
 
-  // CORRECTION single subscriber
-  ros::Subscriber corr_imu_single_sub;
-  ros::Subscriber corr_odo_single_sub;
+  // record the state after a prediction or correction at the stamp
+  virtual void recordStep(RtsSmoother& smoother, const double stamp, const bool correction) = 0;
 
+  // steps are recorded (predict has to keep the Jacobian)
+  bool recording() const { return NULL != smoother; }
 
-  // ROS times and durations
-  ros::Time     pred_last_timestamp;
-  ros::Duration pred_last_delta;
-  ros::Time     corr_last_timestamp;
-  ros::Duration corr_last_delta;
 
-  // ROS publisher or tf broadcaster
-  tf2_ros::TransformBroadcaster br;
-  ros::Publisher odo_pub;
+ private:
+
+  // one processed step and the state after it
+  struct HistoryEntry
+  {
+    bool correction;
+    FilterSample sample;
+    WrapperState state;
+
+    double pred_last_timestamp;
+    double pred_last_delta;
+    double corr_last_timestamp;
+    double corr_last_delta;
+    bool predict_since_last_correct;
+  };
+
+  // reset filter and times (without touching the history)
+  bool resetFilter();
+  bool resetFilterLocked();     // model mutex held
+
+  // filter steps as they are done without history
+  bool predictStep(double current_timestamp,
+                   const OdoData* odo,
+                   const ImuData* imu,
+                   FilterOutput& out,
+                   const bool output);
+  bool correctStep(double current_timestamp,
+                   const OdoData* odo,
+                   const ImuData* imu);
+
+  // process a sample with history (rewinds if the sample is late)
+  bool processSample(const bool correction, const FilterSample& sample,
+                     FilterOutput& out, const bool output);
+
+  // apply a sample older than the newest history entry and re-propagate
+  bool insertLateSample(const bool correction, const FilterSample& sample);
+
+  // history access (0 = oldest entry)
+  HistoryEntry& historyAt(const size_t i);
+  HistoryEntry& appendHistory();
+  void saveHistory(HistoryEntry& entry);
+  void restoreHistory(const HistoryEntry& entry);
+
+  // update the extrapolation snapshot after a filter step
+  void updateSnapshot();
+
+  // calculates the current/old timestamp/delta
+  bool processTimestamp(double& last_t, double& curr_t,
+                        double& last_d, double& curr_d) const;
 
-  // services
-  ros::ServiceServer reload_proc_cov;
+
+  // times and durations [s] (model mutex)
+  double pred_last_timestamp = 0;
+  double pred_last_delta     = 0;
+  double corr_last_timestamp = 0;
+  double corr_last_delta     = 0;
 
   // model mutex
+  void lock();
+  void unlock();
   std::mutex model_mutex;
-  bool predict_since_last_correct;
+  bool locking = true;
+  bool predict_since_last_correct = false;
+
+  // immutable covariance snapshot (std::atomic_load/atomic_store), its
+  // version and the version the filter uses
+  std::shared_ptr<const KalmanCov> kalman_cov = std::make_shared<const KalmanCov>();
+  std::atomic<unsigned> kalman_cov_version{0};
+  unsigned applied_cov_version = 0;
+
+  // stage timing (optional)
+  LatencyStats* latency = NULL;
+
+  // offline smoother recording (optional)
+  RtsSmoother* smoother = NULL;
+
+  // extrapolation snapshot (own mutex, the model mutex may be disabled)
+  bool extrapolation = false;
+  double snapshot_timestamp = 0;
+  std::mutex snapshot_mutex;
+
+  // ring buffer of processed steps (allocated once in setHistorySize)
+  std::vector<HistoryEntry> history;
+  size_t history_start = 0;
+  size_t history_count = 0;
+  std::mutex history_mutex;
 
   // parameter
-  ros::Duration time_threshold;
-  std::string static_frame;
-  std::string moving_frame;
-  std::string corr_odo_topic;
-  std::string pred_odo_topic;
-  std::string corr_imu_topic;
-  std::string pred_imu_topic;
-
-  // debug to file
-  bool debug_out_file;
-  std::ofstream file_out_log;
+  double time_threshold = 0.5;
 
 };
 
@@ -0,0 +1,289 @@
+#ifndef BATCH_PREDICT_H
+#define BATCH_PREDICT_H
+
+// system
+#include <cstddef>
+#include <vector>
+
+// filter core
+#include "CTRA_system_model.h"
+#include "CTRV_system_model.h"
+#include "simd_pack.h"
+
+/*
+ * Batched EKF prediction for many CTRA/CTRV filters
+ *
+ * BatchState keeps the states and 3x3 covariances of N filters in structure
+ * of arrays layout (one array per state element and covariance entry), so
+ * Simd::Pack<T>::WIDTH filters are predicted per iteration. Per lane the
+ * kernels compute the same as ExtendedKalmanFilter::predict with the system
+ * models:
+ *
+ *   x' = f(x, u),   P' = F P F^T + Q
+ *
+ * Both models are evaluated branchless, the straight line (|omega| < 0.01)
+ * and the turning solution are computed for all lanes and blended. Only
+ * F(X,THETA) and F(Y,THETA) differ from identity, they equal -dy and dx of
+ * the position update, so the Jacobian comes for free and F P F^T is
+ * expanded by hand.
+ *
+ * Q is the diagonal process noise (what the wrappers set from kalman_cov).
+ * SIMD lanes need float (see simd_pack.h), double runs one lane at a time.
+ *
+ * test/test_batch_predict.cpp checks the lanes against the generic filter:
+ * relative differences below 1e-4 in float and 1e-12 in double after 800
+ * steps, except CTRA just above the straight threshold, where the turning
+ * solution cancels and both differ by up to 1e-2 in float.
+ *
+ */
+
+namespace BatchPredict {
+
+template<typename T>
+class BatchState
+{
+public:
+
+  // lanes are padded to this (largest SIMD width)
+  enum { PADDING = 8 };
+
+  explicit BatchState(const size_t n = 0) { resize(n); }
+
+  // number of filters (new filters are zero)
+  void resize(const size_t n)
+  {
+    filters = n;
+    const size_t lanes = (n + PADDING - 1) / PADDING * PADDING;
+    x.resize(lanes);
+    y.resize(lanes);
+    theta.resize(lanes);
+    for(size_t k = 0; k < 9; k++)
+      P[k].resize(lanes);
+    for(size_t k = 0; k < 3; k++)
+      Q[k].resize(lanes);
+  }
+
+  size_t size() const { return filters; }
+
+  // padded size (multiple of PADDING)
+  size_t lanes() const { return x.size(); }
+
+  // copy filter i from/to Kalman types
+  template<class S, class Cov>
+  void set(const size_t i, const S& s, const Cov& cov, const Cov& sys_cov)
+  {
+    x[i]     = s.x();
+    y[i]     = s.y();
+    theta[i] = s.theta();
+    for(size_t r = 0; r < 3; r++)
+    {
+      for(size_t c = 0; c < 3; c++)
+        P[3*r + c][i] = cov(r, c);
+      Q[r][i] = sys_cov(r, r);
+    }
+  }
+
+  template<class S, class Cov>
+  void get(const size_t i, S& s, Cov& cov) const
+  {
+    s.x()     = x[i];
+    s.y()     = y[i];
+    s.theta() = theta[i];
+    for(size_t r = 0; r < 3; r++)
+      for(size_t c = 0; c < 3; c++)
+        cov(r, c) = P[3*r + c][i];
+  }
+
+  std::vector<T> x, y, theta;
+
+  // covariance, row major (P[3*row + col])
+  std::vector<T> P[9];
+
+  // diagonal process noise
+  std::vector<T> Q[3];
+
+private:
+
+  size_t filters;
+};
+
+// one control input per filter (a is ignored by CTRV), same padding as the state
+template<typename T>
+struct BatchControl
+{
+  explicit BatchControl(const size_t lanes = 0): dt(lanes), v(lanes), a(lanes), om(lanes) {}
+
+  std::vector<T> dt, v, a, om;
+};
+
+namespace Detail {
+
+// same control for all lanes
+template<typename T>
+struct UniformControl
+{
+  typedef Simd::Pack<T> P;
+
+  UniformControl(T dt_, T v_, T a_, T om_): dt(dt_), v(v_), a(a_), om(om_) {}
+
+  void load(size_t, P& dt_, P& v_, P& a_, P& om_) const
+  {
+    dt_ = dt; v_ = v; a_ = a; om_ = om;
+  }
+
+  P dt, v, a, om;
+};
+
+// control per lane
+template<typename T>
+struct LaneControl
+{
+  typedef Simd::Pack<T> P;
+
+  explicit LaneControl(const BatchControl<T>& u_): u(u_) {}
+
+  void load(size_t i, P& dt, P& v, P& a, P& om) const
+  {
+    dt = P::load(&u.dt[i]);
+    v  = P::load(&u.v[i]);
+    a  = P::load(&u.a[i]);
+    om = P::load(&u.om[i]);
+  }
+
+  const BatchControl<T>& u;
+};
+
+} // namespace Detail
+
+// CTRV::SystemModel::f (a unused), returns position and yaw change
+struct CTRVKernel
+{
+  template<class P>
+  static void step(const P& sin_th, const P& cos_th, const P& sin_th_om, const P& cos_th_om,
+                   const typename P::Mask& straight,
+                   const P& dt, const P& v, const P&, const P& om, const P& om_inv,
+                   P& dx, P& dy, P& dth)
+  {
+    const P vt = v*dt;
+    const P vr = v*om_inv;
+
+    dx  = select(straight, vt*cos_th, vr*(sin_th_om - sin_th));
+    dy  = select(straight, vt*sin_th, vr*(cos_th - cos_th_om));
+    dth = select(straight, P(0), om*dt);
+  }
+};
+
+// CTRA::SystemModel::f, returns position and yaw change
+struct CTRAKernel
+{
+  template<class P>
+  static void step(const P& sin_th, const P& cos_th, const P& sin_th_om, const P& cos_th_om,
+                   const typename P::Mask& straight,
+                   const P& dt, const P& v, const P& a, const P& om, const P& om_inv,
+                   P& dx, P& dy, P& dth)
+  {
+    // straight line
+    const P dist = P(0.5)*dt*(P(2)*v + a*dt);
+
+    // turning
+    const P om2_inv = om_inv*om_inv;
+    const P vom = v*om;
+    const P vom_end = vom + a*om*dt;
+    const P tx = om2_inv*(vom_end*sin_th_om + a*cos_th_om - vom*sin_th - a*cos_th);
+    const P ty = om2_inv*(a*sin_th_om - vom_end*cos_th_om + vom*cos_th - a*sin_th);
+
+    dx  = select(straight, dist*cos_th, tx);
+    dy  = select(straight, dist*sin_th, ty);
+    dth = om*dt;
+  }
+};
+
+namespace Detail {
+
+template<class Kernel, typename T, class Control>
+void run(BatchState<T>& s, const Control& u)
+{
+  typedef Simd::Pack<T> P;
+
+  T* x  = s.x.data();
+  T* y  = s.y.data();
+  T* th = s.theta.data();
+  T* p[9];
+  for(size_t k = 0; k < 9; k++)
+    p[k] = s.P[k].data();
+  const T* q0 = s.Q[0].data();
+  const T* q1 = s.Q[1].data();
+  const T* q2 = s.Q[2].data();
+
+  const size_t lanes = s.lanes();
+  for(size_t i = 0; i < lanes; i += P::WIDTH)
+  {
+    P dt, v, a, om;
+    u.load(i, dt, v, a, om);
+
+    // avoid inf/nan in the (discarded) turning solution of straight lanes
+    const typename P::Mask straight = abs(om) < P(T(0.01));
+    const P om_inv = P(T(1)) / select(straight, P(T(1)), om);
+
+    const P theta = P::load(th + i);
+    P sin_th, cos_th, sin_th_om, cos_th_om;
+    Simd::sincos(theta, sin_th, cos_th);
+    Simd::sincos(fma(om, dt, theta), sin_th_om, cos_th_om);
+
+    P dx, dy, dth;
+    Kernel::step(sin_th, cos_th, sin_th_om, cos_th_om, straight, dt, v, a, om, om_inv, dx, dy, dth);
+
+    (P::load(x + i) + dx).store(x + i);
+    (P::load(y + i) + dy).store(y + i);
+    (theta + dth).store(th + i);
+
+    // F = I except f02 = -dy, f12 = dx
+    const P f02 = -dy;
+    const P f12 = dx;
+
+    const P p00 = P::load(p[0] + i), p01 = P::load(p[1] + i), p02 = P::load(p[2] + i);
+    const P p10 = P::load(p[3] + i), p11 = P::load(p[4] + i), p12 = P::load(p[5] + i);
+    const P p20 = P::load(p[6] + i), p21 = P::load(p[7] + i), p22 = P::load(p[8] + i);
+
+    // M = F P
+    const P m00 = fma(f02, p20, p00), m01 = fma(f02, p21, p01), m02 = fma(f02, p22, p02);
+    const P m10 = fma(f12, p20, p10), m11 = fma(f12, p21, p11), m12 = fma(f12, p22, p12);
+
+    // P' = M F^T + Q
+    (fma(f02, m02, m00) + P::load(q0 + i)).store(p[0] + i);
+    fma(f12, m02, m01).store(p[1] + i);
+    m02.store(p[2] + i);
+    fma(f02, m12, m10).store(p[3] + i);
+    (fma(f12, m12, m11) + P::load(q1 + i)).store(p[4] + i);
+    m12.store(p[5] + i);
+    fma(f02, p22, p20).store(p[6] + i);
+    fma(f12, p22, p21).store(p[7] + i);
+    (p22 + P::load(q2 + i)).store(p[8] + i);
+  }
+}
+
+} // namespace Detail
+
+// all filters with the same control input
+template<typename T>
+void predict(BatchState<T>& s, const CTRV::Control<T>& u)
+{
+  Detail::run<CTRVKernel>(s, Detail::UniformControl<T>(u.dt(), u.v(), T(0), u.om()));
+}
+
+template<typename T>
+void predict(BatchState<T>& s, const CTRA::Control<T>& u)
+{
+  Detail::run<CTRAKernel>(s, Detail::UniformControl<T>(u.dt(), u.v(), u.a(), u.omega()));
+}
+
+// one control input per filter (Kernel: CTRVKernel or CTRAKernel)
+template<class Kernel, typename T>
+void predict(BatchState<T>& s, const BatchControl<T>& u)
+{
+  Detail::run<Kernel>(s, Detail::LaneControl<T>(u));
+}
+
+} // namespace BatchPredict
+
+#endif // BATCH_PREDICT_H
@@ -0,0 +1,92 @@
+#ifndef FILTER_THREAD_H
+#define FILTER_THREAD_H
+
+// system
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// filter core
+#include "base_wrapper.h"
+#include "spsc_queue.h"
+
+/*
+ * Single owner filter thread
+ *
+ * The sensor callbacks only copy their samples into one lock-free ring for
+ * prediction and one for correction. A dedicated thread owns the model and
+ * consumes both rings in timestamp order, so the prediction path never waits
+ * for a running correction or reset.
+ *
+ * Each ring has exactly one producer: all prediction samples must be pushed
+ * from one thread at a time (same for correction).
+ *
+ */
+
+class FilterThread
+{
+public:
+
+  // called from the filter thread before every prediction, returns the outputs
+  // due at the sample stamp (0 skips getOutput and the output callback)
+  typedef std::function<int(double)> OutputDueCallback;
+
+  // called from the filter thread for every successful prediction with output
+  // (outputs as returned by the due callback)
+  typedef std::function<void(const FilterOutput&, int)> OutputCallback;
+
+  // without due callback every prediction has output
+  FilterThread(BaseWrapper* model, size_t queue_size, const OutputCallback& output,
+               const OutputDueCallback& due = OutputDueCallback());
+  ~FilterThread();
+
+  // start/stop the consumer thread
+  void start();
+  void stop();
+
+  // PRODUCER: queue samples (returns false and counts a drop if the ring is full)
+  bool pushPrediction(const FilterSample& sample);
+  bool pushCorrection(const FilterSample& sample);
+
+  // reset (with the current covariance snapshot of the model) before the
+  // next queued sample is processed
+  void requestReset();
+
+  // number of samples dropped because a ring was full
+  size_t droppedPredictions() const { return dropped_pred.load(std::memory_order_relaxed); }
+  size_t droppedCorrections() const { return dropped_corr.load(std::memory_order_relaxed); }
+
+private:
+
+  // consumer loop
+  void run();
+
+  // wake the consumer if it is waiting for data
+  void notify();
+
+  // filter model (only used by the filter thread while running)
+  BaseWrapper* model;
+  OutputCallback output;
+  OutputDueCallback output_due;
+
+  // sample rings
+  SpscQueue<FilterSample> pred_queue;
+  SpscQueue<FilterSample> corr_queue;
+  std::atomic<size_t> dropped_pred{0};
+  std::atomic<size_t> dropped_corr{0};
+
+  // pending reset
+  std::atomic<bool> reset_requested{false};
+
+  // thread and idle wakeup
+  std::thread thread;
+  std::atomic<bool> running{false};
+  std::atomic<bool> waiting{false};
+  std::mutex wait_mutex;
+  std::condition_variable wait_cv;
+
+};
+
+#endif // FILTER_THREAD_H
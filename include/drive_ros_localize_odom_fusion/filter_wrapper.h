@@ -0,0 +1,383 @@
+#ifndef FILTER_WRAPPER_H
+#define FILTER_WRAPPER_H
+
+// system
+#include <algorithm>
+#include <cmath>
+
+// filter core
+#include <kalman/Matrix.hpp>
+#include "base_wrapper.h"
+
+/*
+ * Wrapper of one motion model, implemented once for all models
+ *
+ * Model is a traits struct which lists the types of the model and maps the
+ * input messages to the control input and measurement covariance:
+ *
+ *   struct MyModel
+ *   {
+ *     typedef ... State, Control, Measurement;     // Kalman vectors
+ *     typedef ... SystemModel, MeasurementModel;   // Kalman models
+ *     typedef ... Filter;                          // e.g. PlanarFilter<State>
+ *
+ *     static const char* name();
+ *
+ *     // control input from the prediction messages
+ *     static void control(Control& u, const double dt, const OdoData& odo, const ImuData& imu);
+ *
+ *     // measurement covariance from the correction odometry (cov keeps the previous one)
+ *     static void measurementCovariance(Kalman::Covariance<Measurement>& cov, const OdoData& odo);
+ *   };
+ *
+ * The measurement is the odometry pose relative to the pose of the last
+ * correction (x, y, yaw). New models are added to the list in model_registry.h.
+ *
+ */
+
+template<class Model>
+class FilterWrapper final : public BaseWrapper
+{
+public:
+  typedef typename Model::State State;
+  typedef typename Model::Control Control;
+  typedef typename Model::Measurement Measurement;
+  typedef typename Model::SystemModel SystemModel;
+  typedef typename Model::MeasurementModel MeasurementModel;
+  typedef typename Model::Filter Filter;
+
+  FilterWrapper() {}
+
+private:
+
+  bool initFilterState(const KalmanCov& cov) override;
+  bool setProcessNoise(const KalmanCov& cov) override;
+
+  bool predict(const double dt,
+               const OdoData* odo,
+               const ImuData* imu) override;
+
+  bool correct(const double dt,
+               const OdoData* odo,
+               const ImuData* imu) override;
+
+  bool getOutput(FilterOutput& out) override;
+
+  void saveState(WrapperState& state) const override;
+  void restoreState(const WrapperState& state) override;
+
+  void saveSnapshot() override;
+  bool extrapolateSnapshot(const double dt, FilterOutput& out) override;
+
+  void recordStep(RtsSmoother& smoother, const double stamp, const bool correction) override;
+
+  // pose and covariance to output
+  static void toOutput(const State& state, const Kalman::Covariance<State>& cov, FilterOutput& out);
+
+
+  Control u;
+  Measurement z;
+  SystemModel sys;
+  MeasurementModel mm;
+  Filter filter;
+
+  // process noise of one prediction and the number of IMU samples it is
+  // currently applied for (pre-integration)
+  Kalman::Covariance<State> process_noise;
+  unsigned noise_samples = 1;
+
+  Kalman::Covariance<Measurement> mm_cov;
+  Measurement state_old;
+  Measurement odom_old;
+  double yaw_old;
+
+  // newest state for the extrapolation
+  struct Snapshot
+  {
+    State x;
+    Kalman::Covariance<State> P;
+    Kalman::Covariance<State> Q;
+    Control u;
+  } snapshot;
+
+  // F(X,THETA), F(Y,THETA) of the last prediction (only while recording)
+  typename State::Scalar F_x_theta = 0;
+  typename State::Scalar F_y_theta = 0;
+
+  // coefficients written by saveState()
+  static const int SAVED_SIZE = State::RowsAtCompileTime*(State::RowsAtCompileTime + 1)
+                               + Measurement::RowsAtCompileTime*(Measurement::RowsAtCompileTime + 2) + 1;
+  static_assert(SAVED_SIZE <= int(WrapperState::CAPACITY), "model state does not fit WrapperState::CAPACITY");
+};
+
+
+template<class Model>
+bool FilterWrapper<Model>::initFilterState(const KalmanCov& kalman_cov)
+{
+  bool ret = true;
+
+  FUSION_INFO("Reset Kalman State.");
+
+  // Init kalman
+  State s;
+  s.setZero();
+  filter.init(s);
+  mm_cov.setZero();
+  state_old.setZero();
+  odom_old.setZero();
+  yaw_old = 0;
+
+  // Set initial state covariance
+  Kalman::Covariance<State> stateCov;
+  stateCov.setZero();
+  stateCov(State::X,     State::X)     = kalman_cov.filter_init_var_x;
+  stateCov(State::Y,     State::Y)     = kalman_cov.filter_init_var_y;
+  stateCov(State::THETA, State::THETA) = kalman_cov.filter_init_var_theta;
+  ret &= filter.setCovariance(stateCov);
+
+  FUSION_DEBUG_STREAM("State Cov:\n" << stateCov);
+
+  ret &= setProcessNoise(kalman_cov);
+
+  return ret;
+}
+
+template<class Model>
+bool FilterWrapper<Model>::setProcessNoise(const KalmanCov& kalman_cov)
+{
+  // Set process noise covariance
+  Kalman::Covariance<State> cov;
+  cov.setZero();
+  cov(State::X,     State::X)     = kalman_cov.sys_var_x;
+  cov(State::Y,     State::Y)     = kalman_cov.sys_var_y;
+  cov(State::THETA, State::THETA) = kalman_cov.sys_var_theta;
+  process_noise = cov;
+  noise_samples = 1;
+  const bool ret = sys.setCovariance(cov);
+
+  FUSION_DEBUG_STREAM("Process Cov:\n" << cov);
+
+  return ret;
+}
+
+template<class Model>
+bool FilterWrapper<Model>::predict(const double dt,
+                                   const OdoData* odo,
+                                   const ImuData* imu)
+{
+  // check if the required messages are available
+  if(odo == NULL)
+  {
+    FUSION_ERROR_STREAM("Prediction odometry message required for " << Model::name() << " model! Abort.");
+    return false;
+  }
+
+  if(imu == NULL)
+  {
+    FUSION_ERROR_STREAM("Prediction IMU message required for " << Model::name() << " model! Abort.");
+    return false;
+  }
+
+  Model::control(u, dt, *odo, *imu);
+
+  // pre-integrated IMU samples add the process noise of every sample
+  const unsigned samples = std::max(1u, imu->samples);
+  if(samples != noise_samples)
+  {
+    sys.setCovariance(process_noise * typename State::Scalar(samples));
+    noise_samples = samples;
+  }
+
+  // Jacobian at the previous state for the smoother (F of updateJacobians)
+  if(recording())
+  {
+    sys.jacobianTheta(filter.getState(), u, F_x_theta, F_y_theta);
+  }
+
+  // predict state for current time-step using the kalman filter
+  filter.predict(sys, u);
+
+  // check if there is something wrong
+  if(filter.getCovariance().hasNaN() ||
+     filter.getState().hasNaN()      ||
+     u.hasNaN() )
+  {
+    FUSION_ERROR_STREAM("State covariances or vector is broken!" <<
+                        "\nCovariances:\n" << filter.getCovariance() <<
+                        "\nState:\n"       << filter.getState() <<
+                        "\nInput:\n"       << u);
+    return false;
+  }
+
+  return true;
+}
+
+template<class Model>
+bool FilterWrapper<Model>::correct(const double,
+                                   const OdoData* odo,
+                                   const ImuData*)
+{
+  // check if the required messages are available
+  if(odo == NULL)
+  {
+    FUSION_ERROR_STREAM("Correction odometry message required for " << Model::name() << " model! Abort.");
+    return false;
+  }
+
+  // Set measurement covariances
+  Model::measurementCovariance(mm_cov, *odo);
+  mm.setCovariance(mm_cov);
+
+  // get yaw and prevent yaw overflow
+  double yaw = FusionUtils::yawFromQuaternion(odo->orientation_x, odo->orientation_y,
+                                              odo->orientation_z, odo->orientation_w);
+  yaw = FusionUtils::unwrapYaw(yaw, yaw_old);
+
+  // create differential measurement vector
+  z.x()     = state_old.x()   + odo->position_x - odom_old.x();
+  z.y()     = state_old.y()   + odo->position_y - odom_old.y();
+  z.yaw()   = state_old.yaw() + yaw             - odom_old.yaw();
+
+  FUSION_DEBUG_STREAM("measurementVector: " << z);
+
+  // perform measurement update
+  filter.update(mm, z);
+
+  // check if there is something wrong
+  if(mm_cov.hasNaN() ||
+     z.hasNaN())
+  {
+    FUSION_ERROR("Measurement covariances or vector is broken! Abort.");
+    return false;
+  }
+
+  // save old values (to use differential measurements)
+  state_old = filter.getState();
+  odom_old.x()   = odo->position_x;
+  odom_old.y()   = odo->position_y;
+  odom_old.yaw() = yaw;
+
+  return true;
+}
+
+template<class Model>
+bool FilterWrapper<Model>::getOutput(FilterOutput& out)
+{
+  // get new filter state
+  const auto& state = filter.getState();
+  FUSION_DEBUG_STREAM("newState: " << state);
+
+  // get new filter covariances
+  const auto& cov = filter.getCovariance();
+  FUSION_DEBUG_STREAM("FilterCovariance: " << cov);
+
+  toOutput(state, cov, out);
+  return true;
+}
+
+template<class Model>
+void FilterWrapper<Model>::toOutput(const State& state, const Kalman::Covariance<State>& cov,
+                                    FilterOutput& out)
+{
+  // pose
+  out.x     = state.x();
+  out.y     = state.y();
+  out.theta = state.theta();
+
+  // pose covariance
+  for(int r = 0; r < 3; r++)
+    for(int c = 0; c < 3; c++)
+      out.covariance[r*3 + c] = cov(r, c);
+}
+
+template<class Model>
+void FilterWrapper<Model>::saveState(WrapperState& state) const
+{
+  state.write(filter.getState());
+  state.write(filter.getCovariance());
+  state.write(mm_cov);
+  state.write(state_old);
+  state.write(odom_old);
+  state.write(yaw_old);
+}
+
+template<class Model>
+void FilterWrapper<Model>::restoreState(const WrapperState& state)
+{
+  int pos = 0;
+
+  State s;
+  state.read(s, pos);
+  filter.init(s);
+
+  Kalman::Covariance<State> cov;
+  state.read(cov, pos);
+  filter.setCovariance(cov);
+
+  state.read(mm_cov, pos);
+  state.read(state_old, pos);
+  state.read(odom_old, pos);
+  state.read(yaw_old, pos);
+}
+
+template<class Model>
+void FilterWrapper<Model>::saveSnapshot()
+{
+  snapshot.x = filter.getState();
+  snapshot.P = filter.getCovariance();
+  snapshot.Q = process_noise;
+  snapshot.u = u;
+}
+
+template<class Model>
+bool FilterWrapper<Model>::extrapolateSnapshot(const double dt, FilterOutput& out)
+{
+  if(0 == dt)
+  {
+    toOutput(snapshot.x, snapshot.P, out);
+    return true;
+  }
+
+  // one prediction of a copy with the last control input over dt
+  Filter f;
+  f.init(snapshot.x);
+  f.setCovariance(snapshot.P);
+
+  SystemModel s;
+  s.setCovariance(snapshot.Q);
+
+  Control u_dt = snapshot.u;
+  u_dt.dt() = dt;
+  f.predict(s, u_dt);
+
+  if(f.getState().hasNaN())
+  {
+    return false;
+  }
+
+  toOutput(f.getState(), f.getCovariance(), out);
+  return true;
+}
+
+template<class Model>
+void FilterWrapper<Model>::recordStep(RtsSmoother& smoother, const double stamp, const bool correction)
+{
+  const State& s = filter.getState();
+  const Kalman::Covariance<State>& cov = filter.getCovariance();
+
+  double x[3];
+  double P[9];
+  for(int r = 0; r < 3; r++)
+  {
+    x[r] = s(r);
+    for(int c = 0; c < 3; c++)
+      P[r*3 + c] = cov(r, c);
+  }
+
+  if(correction)
+    smoother.addCorrection(x, P);
+  else
+    smoother.addPrediction(stamp, x, P, F_x_theta, F_y_theta);
+}
+
+#endif // FILTER_WRAPPER_H
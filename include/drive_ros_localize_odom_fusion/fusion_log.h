@@ -0,0 +1,54 @@
+#ifndef FUSION_LOG_H
+#define FUSION_LOG_H
+
+// system
+#include <string>
+#include <sstream>
+
+/*
+ * Minimal logging of the filter core
+ *
+ * Messages go to stderr by default. The ROS node forwards them to rosconsole
+ * by installing its own handler.
+ *
+ */
+
+namespace FusionLog {
+
+enum Level { Debug = 0, Info, Warn, Error, Off };
+
+typedef void (*Handler)(Level level, const std::string& msg);
+
+// set the function which receives all log messages (NULL restores stderr)
+void setHandler(Handler handler);
+
+// messages below this level are dropped before formatting
+void setLevel(Level level);
+bool enabled(Level level);
+
+// write message
+void write(Level level, const std::string& msg);
+
+} // namespace FusionLog
+
+
+#define FUSION_LOG_STREAM(level, args) \
+  do { \
+    if(FusionLog::enabled(level)) { \
+      std::ostringstream fusion_log_ss; \
+      fusion_log_ss << args; \
+      FusionLog::write(level, fusion_log_ss.str()); \
+    } \
+  } while(0)
+
+#define FUSION_DEBUG_STREAM(args) FUSION_LOG_STREAM(FusionLog::Debug, args)
+#define FUSION_INFO_STREAM(args)  FUSION_LOG_STREAM(FusionLog::Info,  args)
+#define FUSION_WARN_STREAM(args)  FUSION_LOG_STREAM(FusionLog::Warn,  args)
+#define FUSION_ERROR_STREAM(args) FUSION_LOG_STREAM(FusionLog::Error, args)
+
+#define FUSION_DEBUG(msg) FUSION_DEBUG_STREAM(msg)
+#define FUSION_INFO(msg)  FUSION_INFO_STREAM(msg)
+#define FUSION_WARN(msg)  FUSION_WARN_STREAM(msg)
+#define FUSION_ERROR(msg) FUSION_ERROR_STREAM(msg)
+
+#endif // FUSION_LOG_H
@@ -0,0 +1,29 @@
+#ifndef FUSION_PRECISION_H
+#define FUSION_PRECISION_H
+
+/*
+ * Scalar types of the wrapped models (ODOM_FUSION_PRECISION in CMake)
+ *
+ *   float   state and covariance math in float (default)
+ *   double  state and covariance math in double
+ *   mixed   pose accumulated in double, covariance math in float
+ *           (mixed needs ODOM_FUSION_PLANAR_EKF, the generic filter
+ *           runs everything in double; CMake rejects it otherwise)
+ *
+ * All three are compiled into the core library, this only selects the
+ * CTRAModel/CTRVModel used by the node and the tools.
+ *
+ */
+
+#if defined(ODOM_FUSION_PRECISION_DOUBLE)
+typedef double FusionScalar;
+typedef double FusionCovScalar;
+#elif defined(ODOM_FUSION_PRECISION_MIXED)
+typedef double FusionScalar;
+typedef float  FusionCovScalar;
+#else
+typedef float  FusionScalar;
+typedef float  FusionCovScalar;
+#endif
+
+#endif // FUSION_PRECISION_H
@@ -0,0 +1,106 @@
+#ifndef FUSION_TYPES_H
+#define FUSION_TYPES_H
+
+// system
+#include <cmath>
+
+// stupid clang compiler
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+/*
+ * ROS independent input and output types of the filter core
+ *
+ * All timestamps are in seconds, all covariances use the row-major
+ * layout of the ROS messages (see cov_elements.h).
+ *
+ */
+
+// IMU sample (subset of sensor_msgs/Imu used by the models)
+struct ImuData
+{
+  double stamp                 = 0;
+  double angular_velocity_z    = 0;
+  double linear_acceleration_x = 0;
+
+  // samples integrated into this one (see imu_preintegration.h), the
+  // prediction adds the process noise once per sample
+  unsigned samples             = 1;
+};
+
+// odometry sample (subset of nav_msgs/Odometry used by the models)
+struct OdoData
+{
+  double stamp              = 0;
+
+  // pose
+  double position_x         = 0;
+  double position_y         = 0;
+  double orientation_x      = 0;
+  double orientation_y      = 0;
+  double orientation_z      = 0;
+  double orientation_w      = 1;
+  double pose_covariance[36] = {};
+
+  // twist
+  double linear_velocity_x  = 0;
+  double linear_velocity_y  = 0;
+};
+
+// filter output (planar pose)
+struct FilterOutput
+{
+  double stamp         = 0;
+  double x             = 0;
+  double y             = 0;
+  double theta         = 0;
+
+  // 3x3 covariance of x, y, theta (row-major)
+  double covariance[9] = {};
+};
+
+// input of one filter step (odo and imu only valid if has_*)
+struct FilterSample
+{
+  double stamp = 0;
+  bool has_odo = false;
+  bool has_imu = false;
+  OdoData odo;
+  ImuData imu;
+};
+
+
+namespace FusionUtils {
+
+// yaw angle of a quaternion (same result as tf::Matrix3x3::getRPY for planar poses)
+inline double yawFromQuaternion(double x, double y, double z, double w)
+{
+  const double d = x*x + y*y + z*z + w*w;
+  const double s = 2.0 / d;
+
+  // rotation matrix elements m[1][0] and m[0][0]
+  const double m10 = x*y*s + w*z*s;
+  const double m00 = 1.0 - (y*y*s + z*z*s);
+
+  return std::atan2(m10, m00);
+}
+
+// unwraps yaw with respect to the last yaw to prevent overflows at +-pi
+inline double unwrapYaw(double yaw, double& yaw_old)
+{
+  if(yaw - yaw_old > M_PI){
+    yaw -= 2*M_PI;
+  }
+
+  if(yaw_old - yaw > M_PI){
+    yaw += 2*M_PI;
+  }
+  yaw_old = yaw;
+
+  return yaw;
+}
+
+} // namespace FusionUtils
+
+#endif // FUSION_TYPES_H
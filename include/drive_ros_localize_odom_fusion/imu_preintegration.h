@@ -0,0 +1,72 @@
+#ifndef IMU_PREINTEGRATION_H
+#define IMU_PREINTEGRATION_H
+
+// filter core
+#include "fusion_types.h"
+
+/*
+ * Pre-integration of high rate IMU prediction samples
+ *
+ * Consecutive prediction samples with IMU data are integrated over a time
+ * window into the yaw and velocity increments
+ *
+ *   d_theta = sum(omega_i * dt_i),   d_v = sum(a_i * dt_i)
+ *
+ * (each sample holds for the interval before its stamp, the same as one
+ * prediction per sample). When the window is full one sample is released
+ * with the stamp of the newest sample, the mean rates d_theta/T and d_v/T
+ * and the newest odometry with its velocity averaged the same way, so a
+ * single prediction over T replaces one per IMU sample. The yaw is the
+ * same as with one prediction per sample, CTRA positions move up to
+ * a*T^2/2 further per window (acceleration applied to the mean velocity).
+ *
+ * The released sample counts the integrated samples (ImuData::samples), so
+ * the prediction adds the process noise Q of every one of them and the
+ * covariance grows as with one prediction per sample.
+ *
+ * Not thread safe.
+ *
+ */
+
+class ImuPreintegration
+{
+public:
+
+  // window [s] (0 releases every sample)
+  explicit ImuPreintegration(const double window = 0);
+
+  void setWindow(const double window);
+  double getWindow() const { return window; }
+
+  // add a prediction sample with IMU data, returns true and the integrated
+  // sample if the window is full
+  bool add(const FilterSample& sample, FilterSample& out);
+
+  // integrated sample of the pending samples, e.g. before a correction
+  // (false if nothing is pending)
+  bool flush(FilterSample& out);
+
+  // drop pending samples and restart
+  void reset();
+
+private:
+
+  double window;
+
+  // stamp of the newest added sample (0 = none yet) and of the last release
+  double last_stamp = 0;
+  double release_stamp = 0;
+
+  // integrals of the pending samples
+  size_t pending = 0;
+  double sum_dt = 0;
+  double sum_omega = 0;
+  double sum_acc = 0;
+  double sum_vx = 0;
+  double sum_vy = 0;
+
+  // newest pending sample (stamp and odometry of the release)
+  FilterSample newest;
+};
+
+#endif // IMU_PREINTEGRATION_H
@@ -0,0 +1,117 @@
+#ifndef INTERPOLATING_SYNC_H
+#define INTERPOLATING_SYNC_H
+
+// system
+#include <cstddef>
+#include <functional>
+
+// filter core
+#include "fusion_types.h"
+
+/*
+ * Low latency synchronizer of odometry and IMU samples
+ *
+ * Instead of pairing messages (message_filters ApproximateTime, which
+ * waits until no better match can come and drops unmatched messages), the
+ * faster stream is linearly interpolated to the stamp of every sample of
+ * the slower stream (the anchor):
+ *
+ *   s(t) = s_lo + (t - t_lo)/(t_hi - t_lo) * (s_hi - s_lo),  t_lo <= t <= t_hi
+ *
+ * A synchronized sample is emitted as soon as the interpolated stream has a
+ * sample at or after the anchor stamp, so the added latency is at most one
+ * period of the faster stream. Anchors are dropped if the bracketing
+ * samples are more than max_interval apart, older than the buffer or not
+ * newer than the previous anchor (out of order samples of the interpolated
+ * stream are ignored).
+ *
+ * IMU: angular velocity and acceleration are interpolated. Odometry:
+ * position, twist and orientation (normalized quaternion lerp), the pose
+ * covariance is taken from the nearer sample.
+ *
+ * Both buffers are fixed size rings, adding samples does not allocate.
+ * Not thread safe, the callback is called from addOdo/addImu.
+ *
+ */
+
+class InterpolatingSync
+{
+public:
+
+  // stream which is interpolated (the faster one)
+  enum Stream { IMU, ODO };
+
+  // synchronized sample (stamp of the anchor, has_odo and has_imu set)
+  typedef std::function<void(const FilterSample&)> Callback;
+
+  InterpolatingSync(const Stream interpolated = IMU, const double max_interval = 0.1);
+
+  void setCallback(const Callback& callback);
+  void setInterpolated(const Stream interpolated);
+  void setMaxInterval(const double max_interval);
+
+  // add a sample, emits all anchors which can be synchronized now
+  void addOdo(const OdoData& odo);
+  void addImu(const ImuData& imu);
+
+  // drop all buffered samples
+  void reset();
+
+  // anchors dropped without synchronized sample
+  size_t dropped() const { return dropped_anchors; }
+
+private:
+
+  enum { CAPACITY = 32 };
+
+  // fixed size ring, the oldest sample is dropped if full
+  template<class T>
+  struct Ring
+  {
+    T data[CAPACITY];
+    size_t start = 0;
+    size_t count = 0;
+
+    bool empty() const { return 0 == count; }
+    size_t size() const { return count; }
+    const T& at(const size_t i) const { return data[(start + i) % CAPACITY]; }
+    const T& front() const { return at(0); }
+    const T& back() const { return at(count - 1); }
+    void pop() { start = (start + 1) % CAPACITY; count--; }
+    void clear() { start = count = 0; }
+
+    // returns false if the oldest sample was dropped
+    bool push(const T& v)
+    {
+      const bool full = (CAPACITY == count);
+      if(full) pop();
+      data[(start + count++) % CAPACITY] = v;
+      return !full;
+    }
+  };
+
+  // emit/drop anchors as far as the interpolated samples allow
+  template<class Anchor, class Sample>
+  void process(Ring<Anchor>& anchors, Ring<Sample>& samples);
+
+  // anchor plus interpolated sample
+  static void combine(const OdoData& anchor, const ImuData& lo, const ImuData& hi,
+                      const double w, FilterSample& out);
+  static void combine(const ImuData& anchor, const OdoData& lo, const OdoData& hi,
+                      const double w, FilterSample& out);
+
+  Stream interpolated;
+  double max_interval;
+  Callback callback;
+
+  Ring<OdoData> odos;
+  Ring<ImuData> imus;
+
+  // newest stamps added (emitted anchors are no longer in the rings)
+  double newest_odo;
+  double newest_imu;
+
+  size_t dropped_anchors = 0;
+};
+
+#endif // INTERPOLATING_SYNC_H
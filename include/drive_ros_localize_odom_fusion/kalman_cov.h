@@ -0,0 +1,52 @@
+#ifndef KALMAN_COV_H
+#define KALMAN_COV_H
+
+// system
+#include <cmath>
+#include <string>
+
+/*
+ * Kalman Filter Covariance Parameters
+ *
+ * Mirrors the kalman_cov parameters of the vehicle config files
+ * (see config folder).
+ *
+ */
+
+struct KalmanCov
+{
+  // initial state covariance
+  double filter_init_var_x     = 0;
+  double filter_init_var_y     = 0;
+  double filter_init_var_theta = 0;
+
+  // process noise covariance
+  double sys_var_x             = 0;
+  double sys_var_y             = 0;
+  double sys_var_theta         = 0;
+
+  // initial variances finite and positive, process noise finite and not negative
+  bool valid(std::string& error) const
+  {
+    const double init[3] = { filter_init_var_x, filter_init_var_y, filter_init_var_theta };
+    const double sys[3]  = { sys_var_x, sys_var_y, sys_var_theta };
+    const char* names[3] = { "x", "y", "theta" };
+
+    for(int i = 0; i < 3; i++)
+    {
+      if(!std::isfinite(init[i]) || init[i] <= 0)
+      {
+        error = std::string("filter_init_var_") + names[i] + " must be positive";
+        return false;
+      }
+      if(!std::isfinite(sys[i]) || sys[i] < 0)
+      {
+        error = std::string("sys_var_") + names[i] + " must not be negative";
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+#endif // KALMAN_COV_H
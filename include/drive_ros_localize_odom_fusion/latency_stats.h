@@ -0,0 +1,118 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+// system
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Lock-free latency histograms of the filter hot path
+ *
+ * LatencyHistogram counts nanosecond values in log-linear buckets (HDR
+ * style): 32 linear sub-buckets per power of two, so percentiles are exact
+ * below 64 ns and within 1/32 (3%) above. Recording is one relaxed atomic
+ * increment (plus a compare-exchange for a new maximum), so any thread can
+ * record while another one reads.
+ *
+ * LatencyStats holds one histogram per stage of a filter step.
+ *
+ */
+
+class LatencyHistogram
+{
+public:
+
+  enum { SUB_BITS    = 5,
+         SUB_BUCKETS = 1 << SUB_BITS,
+         BUCKETS     = (64 - SUB_BITS + 1) * SUB_BUCKETS };
+
+  LatencyHistogram();
+
+  void record(const uint64_t ns)
+  {
+    counts[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = maximum.load(std::memory_order_relaxed);
+    while(ns > max && !maximum.compare_exchange_weak(max, ns, std::memory_order_relaxed));
+  }
+
+  void reset();
+
+  uint64_t count() const { return total.load(std::memory_order_relaxed); }
+  uint64_t max() const   { return maximum.load(std::memory_order_relaxed); }
+
+  // smallest value v with at least the fraction p of the samples <= v
+  // (upper bound of the bucket, 0 without samples)
+  uint64_t percentile(const double p) const;
+
+private:
+
+  static size_t bucket(const uint64_t v)
+  {
+    if(v < SUB_BUCKETS)
+      return v;
+
+    const int msb = 63 - __builtin_clzll(v);
+    const int shift = msb - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((v >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  static uint64_t upperBound(const size_t b);
+
+  std::atomic<uint64_t> counts[BUCKETS];
+  std::atomic<uint64_t> total;
+  std::atomic<uint64_t> maximum;
+};
+
+
+class LatencyStats
+{
+public:
+
+  enum Stage { PRED_DELAY = 0,   // message stamp -> prediction callback
+               CORR_DELAY,       // message stamp -> correction callback
+               MUTEX_WAIT,       // waiting for the model mutex
+               PREDICT,          // wrapper predict
+               CORRECT,          // wrapper correct
+               GET_OUTPUT,       // wrapper getOutput
+               PUBLISH,          // odometry publish
+               SEND_TF,          // tf broadcast
+               DEBUG_LOG,        // debug file output
+               STAGES };
+
+  static const char* name(const Stage stage);
+
+  // monotonic clock [ns]
+  static uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void record(const Stage stage, const uint64_t ns) { stages[stage].record(ns); }
+
+  // record the time since start, returns the current time for the next stage
+  uint64_t lap(const Stage stage, const uint64_t start)
+  {
+    const uint64_t t = now();
+    stages[stage].record(t - start);
+    return t;
+  }
+
+  const LatencyHistogram& stage(const Stage stage) const { return stages[stage]; }
+
+  void reset();
+
+  // table of count, p50, p90, p99, p99.9 and max [us] of all stages
+  std::string report() const;
+
+private:
+
+  LatencyHistogram stages[STAGES];
+};
+
+#endif // LATENCY_STATS_H
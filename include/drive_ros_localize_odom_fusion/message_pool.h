@@ -0,0 +1,78 @@
+#ifndef MESSAGE_POOL_H
+#define MESSAGE_POOL_H
+
+// system
+#include <mutex>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+/*
+ * Pool of reusable messages for shared pointer (intra-process) publishing
+ *
+ * A published message must not change while a subscriber still holds it,
+ * so a pooled message is only handed out again once the pool holds the last
+ * reference. All messages are copies of the prototype, fields which never
+ * change (frame ids) are set once there. Only if every message is still in
+ * use a new one is allocated and kept, so after warm-up get() does not
+ * allocate.
+ *
+ */
+
+template<class M>
+class MessagePool
+{
+public:
+
+  typedef boost::shared_ptr<M> Ptr;
+
+  explicit MessagePool(const size_t size = 8, const M& prototype = M())
+  {
+    setPrototype(prototype, size);
+  }
+
+  // (re)fill the pool with copies of the prototype
+  void setPrototype(const M& p, const size_t size)
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    prototype = p;
+    pool.clear();
+    pool.reserve(size);
+    for(size_t i = 0; i < size; i++)
+    {
+      pool.push_back(Ptr(new M(prototype)));
+    }
+    next = 0;
+  }
+
+  // message nobody else references (may be called from several threads)
+  Ptr get()
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    for(size_t i = 0; i < pool.size(); i++)
+    {
+      const size_t k = (next + i) % pool.size();
+      if(pool[k].unique())
+      {
+        next = (k + 1) % pool.size();
+        return pool[k];
+      }
+    }
+
+    // all in use -> grow
+    pool.push_back(Ptr(new M(prototype)));
+    next = 0;
+    return pool.back();
+  }
+
+  size_t size() const { return pool.size(); }
+
+private:
+
+  M prototype;
+  std::vector<Ptr> pool;
+  size_t next = 0;
+  std::mutex mutex;
+};
+
+#endif // MESSAGE_POOL_H
@@ -0,0 +1,106 @@
+#ifndef MODEL_REGISTRY_H
+#define MODEL_REGISTRY_H
+
+// system
+#include <string>
+
+// filter core
+#include "CTRA_wrapper.h"
+#include "CTRV_wrapper.h"
+
+/*
+ * Compile-time list of all motion models
+ *
+ * The vehicle_model parameter is resolved once at startup, everything after
+ * that works on the concrete FilterWrapper<Model>. To add a model write its
+ * traits (see filter_wrapper.h) and append it to Models.
+ *
+ */
+
+template<class... M>
+struct ModelList {};
+
+// all models, the first one is the default
+typedef ModelList<CTRAModel, CTRVModel> Models;
+
+namespace ModelRegistry {
+
+namespace Detail {
+
+template<class F>
+bool dispatch(const std::string&, F&, ModelList<>)
+{
+  return false;
+}
+
+template<class F, class Head, class... Tail>
+bool dispatch(const std::string& name, F& f, ModelList<Head, Tail...>)
+{
+  if(name == Head::name())
+  {
+    f.template operator()<Head>();
+    return true;
+  }
+  return dispatch(name, f, ModelList<Tail...>());
+}
+
+inline void names(std::string&, ModelList<>) {}
+
+template<class Head, class... Tail>
+void names(std::string& out, ModelList<Head, Tail...>)
+{
+  out += out.empty() ? "" : "|";
+  out += Head::name();
+  names(out, ModelList<Tail...>());
+}
+
+template<class Head, class... Tail>
+const char* first(ModelList<Head, Tail...>)
+{
+  return Head::name();
+}
+
+// creates the wrapper of the dispatched model
+struct Create
+{
+  template<class Model>
+  void operator()() { wrapper = new FilterWrapper<Model>(); }
+
+  BaseWrapper* wrapper = NULL;
+};
+
+} // namespace Detail
+
+// calls f.operator()<Model>() for the model with the given name,
+// returns false for unknown names
+template<class F>
+bool dispatch(const std::string& name, F& f)
+{
+  return Detail::dispatch(name, f, Models());
+}
+
+// new wrapper of the named model (NULL for unknown names)
+inline BaseWrapper* create(const std::string& name)
+{
+  Detail::Create create;
+  dispatch(name, create);
+  return create.wrapper;
+}
+
+// model names separated by '|' (for help texts)
+inline std::string names()
+{
+  std::string out;
+  Detail::names(out, Models());
+  return out;
+}
+
+// name of the default model
+inline std::string defaultName()
+{
+  return Detail::first(Models());
+}
+
+} // namespace ModelRegistry
+
+#endif // MODEL_REGISTRY_H
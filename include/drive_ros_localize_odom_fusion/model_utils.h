@@ -0,0 +1,32 @@
+#ifndef MODEL_UTILS_H
+#define MODEL_UTILS_H
+
+#include <cmath>
+
+namespace ModelUtils {
+
+// sine and cosine of one angle in a single call, in the precision of T
+// (float stays float instead of going through the double sin/cos)
+inline void sincos(const float x, float& s, float& c)
+{
+#if defined(__GNUC__)
+  __builtin_sincosf(x, &s, &c);
+#else
+  s = std::sin(x);
+  c = std::cos(x);
+#endif
+}
+
+inline void sincos(const double x, double& s, double& c)
+{
+#if defined(__GNUC__)
+  __builtin_sincos(x, &s, &c);
+#else
+  s = std::sin(x);
+  c = std::cos(x);
+#endif
+}
+
+} // namespace ModelUtils
+
+#endif // MODEL_UTILS_H
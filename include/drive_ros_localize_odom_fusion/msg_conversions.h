@@ -0,0 +1,105 @@
+#ifndef MSG_CONVERSIONS_H
+#define MSG_CONVERSIONS_H
+
+// ros
+#include <ros/time.h>
+#include <tf2/LinearMath/Quaternion.h>
+
+// ros messages
+#include <geometry_msgs/TransformStamped.h>
+#include <sensor_msgs/Imu.h>
+#include <nav_msgs/Odometry.h>
+
+// filter core
+#include "cov_elements.h"
+#include "fusion_types.h"
+
+/*
+ * Conversions between ROS messages and the filter core types
+ *
+ */
+
+namespace MsgConversions {
+
+// imu message -> core input
+inline void fromMsg(const sensor_msgs::Imu& msg, ImuData& imu)
+{
+  imu.stamp                 = msg.header.stamp.toSec();
+  imu.angular_velocity_z    = msg.angular_velocity.z;
+  imu.linear_acceleration_x = msg.linear_acceleration.x;
+}
+
+// odometry message -> core input
+inline void fromMsg(const nav_msgs::Odometry& msg, OdoData& odo)
+{
+  odo.stamp             = msg.header.stamp.toSec();
+  odo.position_x        = msg.pose.pose.position.x;
+  odo.position_y        = msg.pose.pose.position.y;
+  odo.orientation_x     = msg.pose.pose.orientation.x;
+  odo.orientation_y     = msg.pose.pose.orientation.y;
+  odo.orientation_z     = msg.pose.pose.orientation.z;
+  odo.orientation_w     = msg.pose.pose.orientation.w;
+  odo.linear_velocity_x = msg.twist.twist.linear.x;
+  odo.linear_velocity_y = msg.twist.twist.linear.y;
+
+  for(int i=0; i<36; i++)
+    odo.pose_covariance[i] = msg.pose.covariance[i];
+}
+
+// core output -> tf message (frames are not touched)
+inline void toMsg(const FilterOutput& out, geometry_msgs::TransformStamped& tf_msg)
+{
+  // transform euler to quaternion angles
+  tf2::Quaternion q1;
+  q1.setRPY(0, 0, out.theta);
+
+  tf_msg.header.stamp = ros::Time(out.stamp);
+  tf_msg.transform.translation.x = out.x;
+  tf_msg.transform.translation.y = out.y;
+  tf_msg.transform.translation.z = 0;
+  tf_msg.transform.rotation.x =  q1.x();
+  tf_msg.transform.rotation.y =  q1.y();
+  tf_msg.transform.rotation.z =  q1.z();
+  tf_msg.transform.rotation.w =  q1.w();
+}
+
+// core output -> odometry message (frames are not touched)
+inline void toMsg(const FilterOutput& out, nav_msgs::Odometry& odom_msg)
+{
+  // transform euler to quaternion angles
+  tf2::Quaternion q1;
+  q1.setRPY(0, 0, out.theta);
+
+  odom_msg.header.stamp = ros::Time(out.stamp);
+
+  // odom pose
+  odom_msg.pose.pose.position.x = out.x;
+  odom_msg.pose.pose.position.y = out.y;
+  odom_msg.pose.pose.position.z = 0;
+  odom_msg.pose.pose.orientation.x = q1.x();
+  odom_msg.pose.pose.orientation.y = q1.y();
+  odom_msg.pose.pose.orientation.z = q1.z();
+  odom_msg.pose.pose.orientation.w = q1.w();
+  odom_msg.pose.covariance[CovElem::lin_ang::linX_linX] = out.covariance[0];
+  odom_msg.pose.covariance[CovElem::lin_ang::linX_linY] = out.covariance[1];
+  odom_msg.pose.covariance[CovElem::lin_ang::linX_angZ] = out.covariance[2];
+  odom_msg.pose.covariance[CovElem::lin_ang::linY_linX] = out.covariance[3];
+  odom_msg.pose.covariance[CovElem::lin_ang::linY_linY] = out.covariance[4];
+  odom_msg.pose.covariance[CovElem::lin_ang::linY_angZ] = out.covariance[5];
+  odom_msg.pose.covariance[CovElem::lin_ang::angZ_linX] = out.covariance[6];
+  odom_msg.pose.covariance[CovElem::lin_ang::angZ_linY] = out.covariance[7];
+  odom_msg.pose.covariance[CovElem::lin_ang::angZ_angZ] = out.covariance[8];
+}
+
+// core output -> tf and odometry message (frames are not touched)
+inline void toMsg(const FilterOutput& out,
+                  geometry_msgs::TransformStamped& tf_msg,
+                  nav_msgs::Odometry& odom_msg)
+{
+  toMsg(out, tf_msg);
+  toMsg(out, odom_msg);
+}
+
+} // namespace MsgConversions
+
+#endif // MSG_CONVERSIONS_H
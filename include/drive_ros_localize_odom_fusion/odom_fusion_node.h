@@ -0,0 +1,238 @@
+#ifndef ODOM_FUSION_NODE_H
+#define ODOM_FUSION_NODE_H
+
+// system
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// ros
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <message_filters/subscriber.h>
+#include <message_filters/time_synchronizer.h>
+#include <message_filters/sync_policies/approximate_time.h>
+
+// ros messages
+#include <geometry_msgs/TransformStamped.h>
+#include <sensor_msgs/Imu.h>
+#include <nav_msgs/Odometry.h>
+#include <tf2_msgs/TFMessage.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+// ros services
+#include <std_srvs/Trigger.h>
+
+// filter
+#include "base_wrapper.h"
+#include "filter_thread.h"
+#include "imu_preintegration.h"
+#include "interpolating_sync.h"
+#include "latency_stats.h"
+#include "message_pool.h"
+#include "output_scheduler.h"
+#include "trajectory_log.h"
+
+
+class OdomFusionNode
+{
+public:
+
+  // constructor
+  OdomFusionNode(ros::NodeHandle& n, ros::NodeHandle& p, BaseWrapper* m);
+  ~OdomFusionNode();
+
+  // init publisher, subscriber and some parameters
+  bool initROS();
+
+  // some typedefs
+  typedef message_filters::sync_policies::ApproximateTime<nav_msgs::Odometry,
+                                                          sensor_msgs::Imu> SyncPolicy;
+
+ private:
+
+  // load covariances from parameter server
+  bool loadKalmanCov(KalmanCov& cov);
+
+  // load and validate the covariances and swap them into the model
+  bool reloadKalmanCov();
+
+  // reset filter (with the loaded covariances, no parameter server access)
+  bool reset();
+
+  // start threads for the prediction and correction callback queues
+  void startCallbackThreads(const int pred_threads, const std::vector<int>& pred_cpus,
+                            const int corr_threads, const std::vector<int>& corr_cpus);
+
+  // process one callback queue until ros or the node shuts down
+  void spinQueue(ros::CallbackQueue* queue);
+
+  // services
+  bool svrReset(std_srvs::Trigger::Request  &req,
+                std_srvs::Trigger::Response &res);
+  bool svrReloadCov(std_srvs::Trigger::Request  &req,
+                    std_srvs::Trigger::Response &res);
+  bool svrDumpLatency(std_srvs::Trigger::Request  &req,
+                      std_srvs::Trigger::Response &res);
+
+  // publish the latency percentiles as diagnostics
+  void publishLatency(const ros::TimerEvent&);
+
+  // publish the state extrapolated to the timer time plus lookahead
+  void publishExtrapolation(const ros::TimerEvent& event);
+
+  // PREDICTION: pre-integrate IMU samples (if enabled) and run the prediction
+  void processPredictionData(double current_timestamp,
+                             const OdoData* odo,
+                             const ImuData* imu);
+
+  // run prediction and publish results (or queue for the filter thread)
+  void runPrediction(double current_timestamp,
+                     const OdoData* odo,
+                     const ImuData* imu);
+
+  // predict with the pending pre-integrated IMU samples (prediction mutex)
+  void flushPreintegration();
+
+  // CORRECTION: run correction (or queue for the filter thread)
+  void processCorrectionData(double current_timestamp,
+                             const OdoData* odo,
+                             const ImuData* imu);
+
+  // outputs due for a prediction at the stamp (see OutputScheduler)
+  int outputsDue(double stamp);
+
+  // publish filter output as odometry message and/or tf and log it
+  void publishOutput(const FilterOutput& out, int outputs);
+
+
+  // PREDICTION callback functions
+  void predSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,  // both available
+                        const sensor_msgs::ImuConstPtr &msg_imu);
+  void predOdoCallback (const nav_msgs::OdometryConstPtr &msg_odo); // only odo available
+  void predImuCallback (const sensor_msgs::ImuConstPtr &msg_imu);   // only imu available
+
+  // CORRECTION callback functions
+  void corrSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,  // both available
+                        const sensor_msgs::ImuConstPtr &msg_imu);
+  void corrOdoCallback (const nav_msgs::OdometryConstPtr &msg_odo); // only odo available
+  void corrImuCallback (const sensor_msgs::ImuConstPtr &msg_imu);   // only imu available
+
+  // INTERPOLATING synchronizer callback functions (both topics feed the synchronizer)
+  void predInterpOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo);
+  void predInterpImuCallback(const sensor_msgs::ImuConstPtr &msg_imu);
+  void corrInterpOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo);
+  void corrInterpImuCallback(const sensor_msgs::ImuConstPtr &msg_imu);
+
+  // synchronized samples of the interpolating synchronizers
+  void predInterpCallback(const FilterSample& sample);
+  void corrInterpCallback(const FilterSample& sample);
+
+  // setup an interpolating synchronizer for prediction or correction
+  void setupInterpSync(InterpolatingSync& sync, const std::string& prefix);
+
+
+  // ros node handle
+  ros::NodeHandle nh;
+  ros::NodeHandle pnh;
+
+  // filter model
+  BaseWrapper* model;
+
+  // owns the model if the filter runs in its own thread (NULL otherwise)
+  FilterThread* filter_thread = NULL;
+
+
+  // node handles for the subscribers (own callback queues if enabled)
+  ros::NodeHandle pred_nh;
+  ros::NodeHandle corr_nh;
+  ros::CallbackQueue pred_queue;
+  ros::CallbackQueue corr_queue;
+  std::vector<std::thread> callback_threads;
+  std::atomic<bool> spinning{false};
+
+
+  // PREDICTION subscriber and message filter stuff
+  message_filters::Subscriber<sensor_msgs::Imu>   *pred_imu_sub;
+  message_filters::Subscriber<nav_msgs::Odometry> *pred_odo_sub;
+  message_filters::Synchronizer<SyncPolicy>       *pred_sync;
+  SyncPolicy                                      *pred_policy;
+
+  // PREDICTION single subscriber
+  ros::Subscriber pred_imu_single_sub;
+  ros::Subscriber pred_odo_single_sub;
+
+  // CORRECTION subscriber and message filter stuffe
+  message_filters::Subscriber<sensor_msgs::Imu>   *corr_imu_sub;
+  message_filters::Subscriber<nav_msgs::Odometry> *corr_odo_sub;
+  message_filters::Synchronizer<SyncPolicy>       *corr_sync;
+  SyncPolicy                                      *corr_policy;
+
+  // CORRECTION single subscriber
+  ros::Subscriber corr_imu_single_sub;
+  ros::Subscriber corr_odo_single_sub;
+
+  // interpolating synchronizers (sync_policy "interpolate")
+  InterpolatingSync pred_interp;
+  InterpolatingSync corr_interp;
+  std::mutex pred_interp_mutex;
+  std::mutex corr_interp_mutex;
+
+
+  // ROS publisher (tf published directly, the tf2_ros broadcaster copies
+  // every transform into a new vector)
+  ros::Publisher tf_pub;
+  ros::Publisher odo_pub;
+
+  // reused output messages with the frames already set
+  MessagePool<nav_msgs::Odometry> odom_pool;
+  MessagePool<tf2_msgs::TFMessage> tf_pool;
+  MessagePool<nav_msgs::Odometry> extrapolation_pool;
+
+  // timer driven extrapolated odometry
+  ros::Publisher extrapolation_pub;
+  ros::Timer extrapolation_timer;
+  double extrapolation_lookahead;
+
+  // IMU pre-integration (window 0 = disabled)
+  ImuPreintegration imu_preintegration;
+
+  // prediction path (pre-integration, runPrediction and its outputs), also
+  // taken by the correction callback to flush the pre-integration
+  std::mutex prediction_mutex;
+
+  // output rates (odometry only with subscribers if odom_lazy)
+  OutputScheduler output_scheduler;
+  std::mutex output_mutex;
+  bool odom_lazy;
+
+  // services
+  ros::ServiceServer reload_proc_cov;
+  ros::ServiceServer reload_cov;
+  ros::ServiceServer dump_latency;
+
+  // hot path latency histograms (NULL if disabled)
+  LatencyStats* latency_stats = NULL;
+  ros::Publisher diag_pub;
+  ros::Timer latency_timer;
+
+  // parameter
+  std::string static_frame;
+  std::string moving_frame;
+  std::string corr_odo_topic;
+  std::string pred_odo_topic;
+  std::string corr_imu_topic;
+  std::string pred_imu_topic;
+
+  // debug to file (csv or asynchronous binary log)
+  bool debug_out_file;
+  bool debug_out_binary;
+  std::ofstream file_out_log;
+  TrajectoryLog trajectory_log;
+
+};
+
+#endif
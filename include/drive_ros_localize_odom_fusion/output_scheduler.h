@@ -0,0 +1,53 @@
+#ifndef OUTPUT_SCHEDULER_H
+#define OUTPUT_SCHEDULER_H
+
+/*
+ * Output rates independent of the prediction rate
+ *
+ * The filter predicts with every sample, but odometry and tf are only
+ * produced when due at their own rate. The schedule runs on the sample
+ * stamps (not the wall clock), so a replay publishes the same outputs as the
+ * live node. Rates are in Hz: 0 outputs every prediction, a negative rate
+ * never.
+ *
+ * Not thread safe, due() must be called from one thread at a time.
+ *
+ */
+
+class OutputScheduler
+{
+public:
+
+  // outputs (bit mask, LOG is not scheduled but set by the caller for
+  // outputs which are only logged)
+  enum Output { NONE = 0,
+                ODOM = 1 << 0,
+                TF   = 1 << 1,
+                LOG  = 1 << 2,
+                ALL  = ODOM | TF | LOG };
+
+  void setRates(const double odom_rate, const double tf_rate);
+
+  // outputs due at the sample stamp, advances their schedule
+  int due(const double stamp);
+
+  // restart the schedule (next sample outputs everything enabled)
+  void reset();
+
+private:
+
+  struct Channel
+  {
+    double period = 0;      // [s], 0 = every prediction
+    bool enabled  = true;
+    double next   = 0;      // stamp of the next output (0 = next sample)
+
+    void setRate(const double rate);
+    bool due(const double stamp);
+  };
+
+  Channel odom;
+  Channel tf;
+};
+
+#endif // OUTPUT_SCHEDULER_H
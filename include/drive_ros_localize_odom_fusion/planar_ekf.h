@@ -0,0 +1,137 @@
+#ifndef PLANAR_EKF_H
+#define PLANAR_EKF_H
+
+// system
+#include <type_traits>
+
+#include <kalman/ExtendedKalmanFilter.hpp>
+#include <kalman/Matrix.hpp>
+
+/*
+ * Extended Kalman Filter specialized for the 3-state planar models
+ *
+ * Drop-in replacement for Kalman::ExtendedKalmanFilter with the CTRA/CTRV
+ * system and measurement models, which have
+ *   F = identity except F(X,THETA), F(Y,THETA)  (SystemModel::transition)
+ *   H = identity, W = V = identity
+ * so the filter works on these entries instead of dense matrix products:
+ *
+ *   predict:  P' = F P F^T + Q        (two rows and columns updated)
+ *   update:   S  = P + R, K = P S^-1  (closed form 3x3 inverse)
+ *             x' = x + K (z - h(x)),  P' = P - K P
+ *
+ * The result equals the generic filter up to floating point rounding.
+ *
+ * With CovScalar float and a double state (mixed precision) the pose is
+ * accumulated in double while P, S and K are computed in float: the
+ * Jacobian entries, Q, R and the innovation are converted once per step.
+ *
+ */
+
+template<class StateType, typename CovScalar = typename StateType::Scalar>
+class PlanarEKF
+{
+public:
+  typedef StateType State;
+  typedef typename State::Scalar T;
+  typedef CovScalar Tc;
+  typedef Kalman::Covariance<State> Covariance;
+
+  static_assert(3 == State::RowsAtCompileTime, "PlanarEKF requires the 3-state planar models");
+
+  // covariance in the precision of the math, returned by reference if
+  // that is the state precision and converted otherwise
+  typedef typename std::conditional<std::is_same<T, Tc>::value,
+                                    Covariance, Eigen::Matrix<Tc, 3, 3> >::type CovarianceStorage;
+  typedef typename std::conditional<std::is_same<T, Tc>::value,
+                                    const Covariance&, Covariance>::type CovarianceResult;
+
+  PlanarEKF()
+  {
+    x.setZero();
+    P.setIdentity();
+  }
+
+  void init(const State& s) { x = s; }
+  const State& getState() const { return x; }
+
+  CovarianceResult getCovariance() const { return toCovariance(P); }
+  bool setCovariance(const Covariance& cov) { P = cov.template cast<Tc>(); return true; }
+
+  template<class SystemModel>
+  const State& predict(const SystemModel& sys, const typename SystemModel::C& u)
+  {
+    // transition and Jacobian at the previous state in one pass
+    T f_a, f_b;
+    x = sys.transition(x, u, f_a, f_b);
+    const Tc a = f_a;
+    const Tc b = f_b;
+
+    // rows: M = F P
+    P(0,0) += a*P(2,0); P(0,1) += a*P(2,1); P(0,2) += a*P(2,2);
+    P(1,0) += b*P(2,0); P(1,1) += b*P(2,1); P(1,2) += b*P(2,2);
+
+    // columns: M F^T
+    P(0,0) += a*P(0,2); P(0,1) += b*P(0,2);
+    P(1,0) += a*P(1,2); P(1,1) += b*P(1,2);
+    P(2,0) += a*P(2,2); P(2,1) += b*P(2,2);
+
+    P += sys.getCovariance().template cast<Tc>();
+    return x;
+  }
+
+  template<class MeasurementModel>
+  const State& update(const MeasurementModel& mm, const typename MeasurementModel::M& z)
+  {
+    typedef Eigen::Matrix<Tc, 3, 3> Matrix;
+
+    // innovation covariance
+    const Matrix S = P + mm.getCovariance().template cast<Tc>();
+
+    // adjugate / determinant (S is not assumed to be symmetric, the
+    // measurement covariance comes from the odometry message as it is)
+    Matrix S_inv;
+    S_inv(0,0) = S(1,1)*S(2,2) - S(1,2)*S(2,1);
+    S_inv(1,0) = S(1,2)*S(2,0) - S(1,0)*S(2,2);
+    S_inv(2,0) = S(1,0)*S(2,1) - S(1,1)*S(2,0);
+
+    const Tc det = S(0,0)*S_inv(0,0) + S(0,1)*S_inv(1,0) + S(0,2)*S_inv(2,0);
+    const Tc inv_det = Tc(1)/det;
+
+    S_inv(0,1) = S(0,2)*S(2,1) - S(0,1)*S(2,2);
+    S_inv(1,1) = S(0,0)*S(2,2) - S(0,2)*S(2,0);
+    S_inv(2,1) = S(0,1)*S(2,0) - S(0,0)*S(2,1);
+    S_inv(0,2) = S(0,1)*S(1,2) - S(0,2)*S(1,1);
+    S_inv(1,2) = S(0,2)*S(1,0) - S(0,0)*S(1,2);
+    S_inv(2,2) = S(0,0)*S(1,1) - S(0,1)*S(1,0);
+    S_inv *= inv_det;
+
+    // gain and correction (innovation in the state precision)
+    const Matrix K = P * S_inv;
+    x += (K * (z - mm.h(x)).template cast<Tc>()).template cast<T>();
+    P -= K * P;
+    return x;
+  }
+
+private:
+
+  static const Covariance& toCovariance(const Covariance& cov) { return cov; }
+
+  template<class M>
+  static Covariance toCovariance(const M& cov) { return cov.template cast<T>(); }
+
+  State x;
+  CovarianceStorage P;
+};
+
+// filter of the planar models in the wrappers (see ODOM_FUSION_PLANAR_EKF),
+// the generic filter computes the covariance in the state precision
+#ifdef ODOM_FUSION_PLANAR_EKF
+template<class State, typename CovScalar = typename State::Scalar>
+using PlanarFilter = PlanarEKF<State, CovScalar>;
+#else
+template<class State, typename CovScalar = typename State::Scalar>
+using PlanarFilter = Kalman::ExtendedKalmanFilter<State>;
+#endif
+
+#endif // PLANAR_EKF_H
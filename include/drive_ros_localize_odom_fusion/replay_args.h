@@ -0,0 +1,106 @@
+#ifndef REPLAY_ARGS_H
+#define REPLAY_ARGS_H
+
+// system
+#include <map>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <yaml-cpp/yaml.h>
+#include <ros/console.h>
+
+// filter core
+#include "kalman_cov.h"
+#include "replay_events.h"
+
+/*
+ * Command line handling shared by the offline tools
+ *
+ * Arguments are "--key value" pairs using the same names as the node
+ * parameters.
+ *
+ */
+
+namespace Replay {
+
+typedef std::map<std::string, std::string> Args;
+
+// parse "--key value" arguments
+inline bool parseArgs(int argc, char **argv, Args& args)
+{
+  for(int i = 1; i < argc; i++)
+  {
+    std::string key = argv[i];
+    if(key.compare(0, 2, "--") != 0 || i+1 >= argc)
+    {
+      std::cout << "Invalid argument provided: " << key << std::endl;
+      return false;
+    }
+    args[key.substr(2)] = argv[++i];
+  }
+  return true;
+}
+
+// get argument or default value
+template<typename T>
+inline T param(const Args& args, const std::string& key, const T& default_val)
+{
+  auto it = args.find(key);
+  if(args.end() == it)
+    return default_val;
+
+  std::istringstream ss(it->second);
+  T val;
+  ss >> val;
+  return val;
+}
+
+template<>
+inline std::string param(const Args& args, const std::string& key, const std::string& default_val)
+{
+  auto it = args.find(key);
+  return args.end() == it ? default_val : it->second;
+}
+
+// load kalman_cov group of a vehicle config file
+inline bool loadKalmanCov(const std::string& file, KalmanCov& cov)
+{
+  try{
+    YAML::Node kc = YAML::LoadFile(file)["kalman_cov"];
+
+    cov.filter_init_var_x     = kc["filter_init_var_x"].as<double>();
+    cov.filter_init_var_y     = kc["filter_init_var_y"].as<double>();
+    cov.filter_init_var_theta = kc["filter_init_var_theta"].as<double>();
+    cov.sys_var_x             = kc["sys_var_x"].as<double>();
+    cov.sys_var_y             = kc["sys_var_y"].as<double>();
+    cov.sys_var_theta         = kc["sys_var_theta"].as<double>();
+
+  }catch(const YAML::Exception& e){
+    ROS_ERROR_STREAM("Loading kalman_cov from " << file << " failed: " << e.what());
+    return false;
+  }
+
+  return true;
+}
+
+// topics and synchronizer parameters
+inline void loadConfig(const Args& args, Config& config)
+{
+  config.pred_odo_topic = param<std::string>(args, "pred_odo_topic_name", "");
+  config.pred_imu_topic = param<std::string>(args, "pred_imu_topic_name", "");
+  config.corr_odo_topic = param<std::string>(args, "corr_odo_topic_name", "");
+  config.corr_imu_topic = param<std::string>(args, "corr_imu_topic_name", "");
+  config.queue_size                    = param<int>(args, "queue_size", config.queue_size);
+  config.pred_age_penalty              = param<double>(args, "pred_age_penalty", config.pred_age_penalty);
+  config.pred_max_time_between_imu_odo = param<double>(args, "pred_max_time_between_imu_odo", config.pred_max_time_between_imu_odo);
+  config.pred_odo_topic_rate           = param<double>(args, "pred_odo_topic_rate", config.pred_odo_topic_rate);
+  config.pred_imu_topic_rate           = param<double>(args, "pred_imu_topic_rate", config.pred_imu_topic_rate);
+  config.corr_age_penalty              = param<double>(args, "corr_age_penalty", config.corr_age_penalty);
+  config.corr_max_time_between_imu_odo = param<double>(args, "corr_max_time_between_imu_odo", config.corr_max_time_between_imu_odo);
+  config.corr_odo_topic_rate           = param<double>(args, "corr_odo_topic_rate", config.corr_odo_topic_rate);
+  config.corr_imu_topic_rate           = param<double>(args, "corr_imu_topic_rate", config.corr_imu_topic_rate);
+}
+
+} // namespace Replay
+
+#endif // REPLAY_ARGS_H
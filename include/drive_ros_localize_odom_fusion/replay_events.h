@@ -0,0 +1,71 @@
+#ifndef REPLAY_EVENTS_H
+#define REPLAY_EVENTS_H
+
+// system
+#include <string>
+#include <vector>
+#include <functional>
+
+// filter core
+#include "base_wrapper.h"
+
+/*
+ * Offline replay of recorded sensor data
+ *
+ * Reads the prediction and correction topics from a bag file and turns them
+ * into the same sequence of prediction/correction calls the node would issue.
+ * No ROS master is required.
+ *
+ */
+
+namespace Replay {
+
+// one filter step as it would be triggered by a node callback
+struct Event
+{
+  enum Type { PREDICTION, CORRECTION };
+
+  Type type;
+  double stamp;
+
+  // inputs (only valid if has_*)
+  bool has_odo;
+  bool has_imu;
+  OdoData odo;
+  ImuData imu;
+};
+
+// topics and synchronizer settings (same meaning as the node parameters)
+struct Config
+{
+  std::string pred_odo_topic;
+  std::string pred_imu_topic;
+  std::string corr_odo_topic;
+  std::string corr_imu_topic;
+
+  int    queue_size                    = 5;
+  double pred_age_penalty              = 5;
+  double pred_max_time_between_imu_odo = 0.01;
+  double pred_odo_topic_rate           = 100;
+  double pred_imu_topic_rate           = 100;
+  double corr_age_penalty              = 5;
+  double corr_max_time_between_imu_odo = 0.1;
+  double corr_odo_topic_rate           = 100;
+  double corr_imu_topic_rate           = 100;
+};
+
+// called for every successful prediction with the filter output
+typedef std::function<void(const FilterOutput&)> OutputCallback;
+
+// decode the bag into a list of filter steps (in processing order)
+bool loadEvents(const std::string& bag_file, const Config& config,
+                std::vector<Event>& events);
+
+// run all events through the model, returns number of successful predictions
+// (ROS independent, replay_run.cpp)
+size_t run(BaseWrapper& model, const std::vector<Event>& events,
+           const OutputCallback& output);
+
+} // namespace Replay
+
+#endif // REPLAY_EVENTS_H
@@ -0,0 +1,71 @@
+#ifndef REPLAY_SYNTHETIC_H
+#define REPLAY_SYNTHETIC_H
+
+// system
+#include <memory>
+#include <string>
+#include <vector>
+
+// filter core
+#include "replay_events.h"
+#include "trajectory_columns.h"
+
+/*
+ * Deterministic synthetic sequences and golden trajectory comparison
+ *
+ * The synthetic sequences are generated in code (fixed seed, own normal
+ * noise, no wall clock), so every run feeds the filter the same events:
+ * 100 Hz prediction (odometry twist and IMU) and 20 Hz correction odometry
+ * (pose with random walk drift and growing covariance) of a simulated drive.
+ *
+ *   straight     constant velocity, no turn
+ *   circle       constant velocity and yaw rate
+ *   slalom       sinusoidal yaw rate and acceleration
+ *   stop_and_go  velocity down to standstill and back up
+ *   time_jump    gap above time_threshold in the middle (filter reset)
+ *
+ * Golden trajectories are columnar files (see trajectory_columns.h) of the
+ * filter output for the same input, produced by regressionModel() (fixed
+ * covariances, the tuned vehicle configs change over time). They are checked
+ * by the replay tool (--regression) and the unit tests.
+ *
+ */
+
+namespace Replay {
+
+// names of all synthetic sequences
+const std::vector<std::string>& syntheticNames();
+
+// events of a synthetic sequence (false for unknown names)
+bool syntheticEvents(const std::string& name, std::vector<Event>& events);
+
+// largest deviation from a golden trajectory
+struct GoldenDiff
+{
+  bool   rows_match = false;    // same number of rows and stamps
+  double position   = 0;        // [m]
+  double theta      = 0;        // [rad]
+  double covariance = 0;        // largest absolute difference of all elements
+};
+
+// compare a trajectory with a golden one row by row
+void compareGolden(const std::vector<FilterOutput>& trajectory,
+                   const TrajectoryColumns& golden, GoldenDiff& diff);
+
+// largest accepted deviation from a golden trajectory
+struct GoldenTolerance
+{
+  double position   = 1e-3;     // [m]
+  double theta      = 1e-4;     // [rad]
+  double covariance = 1e-6;
+};
+
+// same rows and every deviation within the tolerance
+bool withinTolerance(const GoldenDiff& diff, const GoldenTolerance& tolerance);
+
+// reset model of the regression runs (NULL for unknown names)
+std::unique_ptr<BaseWrapper> regressionModel(const std::string& model_name);
+
+} // namespace Replay
+
+#endif // REPLAY_SYNTHETIC_H
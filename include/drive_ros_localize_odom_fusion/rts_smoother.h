@@ -0,0 +1,98 @@
+#ifndef RTS_SMOOTHER_H
+#define RTS_SMOOTHER_H
+
+// system
+#include <cstddef>
+#include <vector>
+
+// filter core
+#include "fusion_types.h"
+
+/*
+ * Offline Rauch-Tung-Striebel smoother of the planar models
+ *
+ * The forward pass (a wrapper with setSmoother()) records per prediction
+ * the predicted state x_p, P_p, the Jacobian entries F(X,THETA), F(Y,THETA)
+ * of the transition into it (the rest of F is the identity, see the system
+ * models) and the filtered state x_f, P_f (= predicted, or the result of a
+ * correction at this step). The backward pass then runs
+ *
+ *   C_k   = P_f,k F_k+1^T P_p,k+1^-1
+ *   x_s,k = x_f,k + C_k (x_s,k+1 - x_p,k+1)
+ *   P_s,k = P_f,k + C_k (P_s,k+1 - P_p,k+1) C_k^T
+ *
+ * starting with x_s = x_f at the newest step. A filter reset starts a new
+ * chain which is smoothed on its own.
+ *
+ * Steps are stored contiguously with the upper triangles of the symmetric
+ * covariances. Long recordings can be smoothed in chunks in parallel: every
+ * chunk starts its backward pass `overlap` steps after its end with the
+ * filtered state there, so the approximation error decays over the overlap
+ * before the steps of the chunk are reached (exact with chunk = 0). It is
+ * largest while the filter converges after a reset: on the synthetic
+ * sequences chunk 100 deviates from the exact pass by up to 2e-2 m and
+ * 6.5e-3 rad with overlap 50 (below 1.3e-3 m elsewhere) and 1e-3 m and rad
+ * with overlap 200 (checked by test/test_rts_smoother.cpp).
+ *
+ * Recording is not thread safe and needs a wrapper without history (late
+ * samples would record re-propagated steps twice).
+ *
+ */
+
+class RtsSmoother
+{
+public:
+
+  // one step of the forward pass
+  struct Step
+  {
+    double stamp;
+
+    // no transition from the previous step (first step after a reset)
+    bool chain_start;
+
+    // F(X,THETA), F(Y,THETA) of the transition from the previous step
+    double F_x_theta;
+    double F_y_theta;
+
+    // predicted and filtered state (x, y, theta) and covariance
+    // (upper triangle: xx, xy, xt, yy, yt, tt)
+    double x_p[3];
+    double P_p[6];
+    double x_f[3];
+    double P_f[6];
+  };
+
+  // drop all steps
+  void clear();
+  void reserve(const size_t steps);
+
+  // FORWARD PASS: state after a prediction (new step, row-major 3x3 covariance)
+  void addPrediction(const double stamp, const double x[3], const double P[9],
+                     const double F_x_theta, const double F_y_theta);
+
+  // FORWARD PASS: state after a correction of the newest step
+  void addCorrection(const double x[3], const double P[9]);
+
+  // FORWARD PASS: the filter was reset, the next step starts a new chain
+  void startChain();
+
+  size_t size() const { return steps.size(); }
+  const std::vector<Step>& getSteps() const { return steps; }
+
+  // BACKWARD PASS: smoothed state of every step (chunk 0 = one exact pass,
+  // threads 0 = one per hardware thread)
+  void smooth(std::vector<FilterOutput>& out, const size_t chunk = 0,
+              const size_t overlap = 0, size_t threads = 0) const;
+
+private:
+
+  // backward pass over [begin, start] (start >= end - 1), output of [begin, end)
+  void smoothRange(const size_t begin, const size_t end, const size_t start,
+                   FilterOutput* out) const;
+
+  std::vector<Step> steps;
+  bool chain_start = true;
+};
+
+#endif // RTS_SMOOTHER_H
@@ -9,7 +9,7 @@ namespace SaveOdomInCSV
 {
 
 // write header file of output log file
-void writeHeader(const std::string& filename, std::ofstream& file_out_log)
+inline void writeHeader(const std::string& filename, std::ofstream& file_out_log)
 {
   file_out_log.open( filename );
 
@@ -39,7 +39,7 @@ void writeHeader(const std::string& filename, std::ofstream& file_out_log)
 }
 
 // write the odometry message to output log file
-void writeMsg(const nav_msgs::Odometry& msg, std::ofstream& file_out_log)
+inline void writeMsg(const nav_msgs::Odometry& msg, std::ofstream& file_out_log)
 {
   file_out_log << msg.header.stamp.toSec() << ",";
 
@@ -0,0 +1,199 @@
+#ifndef SIMD_PACK_H
+#define SIMD_PACK_H
+
+// system
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define ODOM_FUSION_SIMD_AVX2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ODOM_FUSION_SIMD_NEON
+#endif
+
+/*
+ * Minimal SIMD abstraction for the batch kernels
+ *
+ * Pack<T> holds Pack<T>::WIDTH lanes of T and offers the arithmetic, compare
+ * and blend operations the kernels need. float uses AVX2 (8 lanes, compile
+ * with -mavx2 -mfma) or NEON (4 lanes, AArch64), everything else falls back
+ * to one lane of plain scalar code. Loads and stores are unaligned.
+ *
+ */
+
+namespace Simd {
+
+// scalar fallback (one lane)
+template<typename T>
+struct Pack
+{
+  enum { WIDTH = 1 };
+  typedef bool Mask;
+
+  T v;
+
+  Pack() {}
+  Pack(T x): v(x) {}
+
+  static Pack load(const T* p)  { return Pack(*p); }
+  void store(T* p) const        { *p = v; }
+
+  friend Pack operator+(Pack a, Pack b) { return Pack(a.v + b.v); }
+  friend Pack operator-(Pack a, Pack b) { return Pack(a.v - b.v); }
+  friend Pack operator*(Pack a, Pack b) { return Pack(a.v * b.v); }
+  friend Pack operator/(Pack a, Pack b) { return Pack(a.v / b.v); }
+  friend Pack operator-(Pack a)         { return Pack(-a.v); }
+
+  // a*b + c
+  friend Pack fma(Pack a, Pack b, Pack c) { return Pack(a.v*b.v + c.v); }
+
+  friend Pack abs(Pack a)   { return Pack(std::abs(a.v)); }
+  friend Pack round(Pack a) { return Pack(std::nearbyint(a.v)); }
+  friend Pack floor(Pack a) { return Pack(std::floor(a.v)); }
+
+  friend Mask operator<(Pack a, Pack b)  { return a.v < b.v; }
+  friend Mask operator>=(Pack a, Pack b) { return a.v >= b.v; }
+  friend Mask operator==(Pack a, Pack b) { return a.v == b.v; }
+
+  // m ? a : b
+  friend Pack select(Mask m, Pack a, Pack b) { return m ? a : b; }
+};
+
+inline bool maskOr(bool a, bool b)  { return a || b; }
+
+#if defined(ODOM_FUSION_SIMD_AVX2)
+
+template<>
+struct Pack<float>
+{
+  enum { WIDTH = 8 };
+  typedef __m256 Mask;
+
+  __m256 v;
+
+  Pack() {}
+  Pack(__m256 x): v(x) {}
+  Pack(float x): v(_mm256_set1_ps(x)) {}
+
+  static Pack load(const float* p) { return Pack(_mm256_loadu_ps(p)); }
+  void store(float* p) const       { _mm256_storeu_ps(p, v); }
+
+  friend Pack operator+(Pack a, Pack b) { return Pack(_mm256_add_ps(a.v, b.v)); }
+  friend Pack operator-(Pack a, Pack b) { return Pack(_mm256_sub_ps(a.v, b.v)); }
+  friend Pack operator*(Pack a, Pack b) { return Pack(_mm256_mul_ps(a.v, b.v)); }
+  friend Pack operator/(Pack a, Pack b) { return Pack(_mm256_div_ps(a.v, b.v)); }
+  friend Pack operator-(Pack a)         { return Pack(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+
+  friend Pack fma(Pack a, Pack b, Pack c) { return Pack(_mm256_fmadd_ps(a.v, b.v, c.v)); }
+
+  friend Pack abs(Pack a)   { return Pack(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+  friend Pack round(Pack a) { return Pack(_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); }
+  friend Pack floor(Pack a) { return Pack(_mm256_floor_ps(a.v)); }
+
+  friend Mask operator<(Pack a, Pack b)  { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+  friend Mask operator>=(Pack a, Pack b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+  friend Mask operator==(Pack a, Pack b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+
+  friend Pack select(Mask m, Pack a, Pack b) { return Pack(_mm256_blendv_ps(b.v, a.v, m)); }
+};
+
+inline __m256 maskOr(__m256 a, __m256 b) { return _mm256_or_ps(a, b); }
+
+#elif defined(ODOM_FUSION_SIMD_NEON)
+
+template<>
+struct Pack<float>
+{
+  enum { WIDTH = 4 };
+  typedef uint32x4_t Mask;
+
+  float32x4_t v;
+
+  Pack() {}
+  Pack(float32x4_t x): v(x) {}
+  Pack(float x): v(vdupq_n_f32(x)) {}
+
+  static Pack load(const float* p) { return Pack(vld1q_f32(p)); }
+  void store(float* p) const       { vst1q_f32(p, v); }
+
+  friend Pack operator+(Pack a, Pack b) { return Pack(vaddq_f32(a.v, b.v)); }
+  friend Pack operator-(Pack a, Pack b) { return Pack(vsubq_f32(a.v, b.v)); }
+  friend Pack operator*(Pack a, Pack b) { return Pack(vmulq_f32(a.v, b.v)); }
+  friend Pack operator/(Pack a, Pack b) { return Pack(vdivq_f32(a.v, b.v)); }
+  friend Pack operator-(Pack a)         { return Pack(vnegq_f32(a.v)); }
+
+  friend Pack fma(Pack a, Pack b, Pack c) { return Pack(vfmaq_f32(c.v, a.v, b.v)); }
+
+  friend Pack abs(Pack a)   { return Pack(vabsq_f32(a.v)); }
+  friend Pack round(Pack a) { return Pack(vrndnq_f32(a.v)); }
+  friend Pack floor(Pack a) { return Pack(vrndmq_f32(a.v)); }
+
+  friend Mask operator<(Pack a, Pack b)  { return vcltq_f32(a.v, b.v); }
+  friend Mask operator>=(Pack a, Pack b) { return vcgeq_f32(a.v, b.v); }
+  friend Mask operator==(Pack a, Pack b) { return vceqq_f32(a.v, b.v); }
+
+  friend Pack select(Mask m, Pack a, Pack b) { return Pack(vbslq_f32(m, a.v, b.v)); }
+};
+
+inline uint32x4_t maskOr(uint32x4_t a, uint32x4_t b) { return vorrq_u32(a, b); }
+
+#endif
+
+// sin and cos of all SIMD lanes
+//
+// Reduction to [-pi/4, pi/4] by the nearest multiple of pi/2 (Cody-Waite,
+// three parts), minimax polynomials of the cephes sinf/cosf and the quadrant
+// applied by blends. Max. error about 2 ulp for |x| < 1e4, which covers the
+// unwrapped yaw of the filters.
+template<typename P>
+inline void sincos(const P x, P& s, P& c, std::false_type)
+{
+  const P q = round(x * P(0.63661977236758134f));   // 2/pi
+  P r = fma(q, P(-1.5703125f), x);
+  r = fma(q, P(-4.837512969970703125e-4f), r);
+  r = fma(q, P(-7.54978995489188216e-8f), r);
+
+  const P r2 = r*r;
+
+  P ps = fma(r2, P(-1.9515295891e-4f), P(8.3321608736e-3f));
+  ps = fma(ps, r2, P(-1.6666654611e-1f));
+  ps = fma(ps*r2, r, r);
+
+  P pc = fma(r2, P(2.443315711809948e-5f), P(-1.388731625493765e-3f));
+  pc = fma(pc, r2, P(4.166664568298827e-2f));
+  pc = fma(pc*r2, r2, fma(r2, P(-0.5f), P(1.0f)));
+
+  // quadrant k = q mod 4
+  const P k = q - P(4.0f)*floor(q * P(0.25f));
+  const typename P::Mask k1 = (k == P(1.0f));
+  const typename P::Mask k2 = (k == P(2.0f));
+  const typename P::Mask k3 = (k == P(3.0f));
+
+  // k = 0: ( s,  c)  k = 1: ( c, -s)  k = 2: (-s, -c)  k = 3: (-c,  s)
+  const typename P::Mask odd = maskOr(k1, k3);
+  const P s_base = select(odd, pc, ps);
+  const P c_base = select(odd, ps, pc);
+  s = select(maskOr(k2, k3), -s_base, s_base);
+  c = select(maskOr(k1, k2), -c_base, c_base);
+}
+
+// one lane: libm, same results as the scalar models
+template<typename P>
+inline void sincos(const P x, P& s, P& c, std::true_type)
+{
+  s = P(std::sin(x.v));
+  c = P(std::cos(x.v));
+}
+
+template<typename T>
+inline void sincos(const Pack<T> x, Pack<T>& s, Pack<T>& c)
+{
+  sincos(x, s, c, std::integral_constant<bool, 1 == Pack<T>::WIDTH>());
+}
+
+} // namespace Simd
+
+#endif // SIMD_PACK_H
@@ -0,0 +1,99 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+// system
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Lock-free single-producer/single-consumer ring buffer
+ *
+ * Exactly one thread may call push() and exactly one (other) thread may call
+ * front()/pop(). The capacity is rounded up to a power of two and allocated
+ * once in the constructor, push() and pop() never allocate or block.
+ *
+ */
+
+template<typename T>
+class SpscQueue
+{
+public:
+
+  explicit SpscQueue(size_t capacity)
+  {
+    size_t size = 2;
+    while(size < capacity)
+      size <<= 1;
+
+    buffer.resize(size);
+    mask = size - 1;
+  }
+
+  // PRODUCER: copy item into the ring, returns false if the ring is full
+  bool push(const T& item)
+  {
+    const size_t t = tail.load(std::memory_order_relaxed);
+
+    // only reload the consumer index if the cached one says we are full
+    if(t - head_cache > mask)
+    {
+      head_cache = head.load(std::memory_order_acquire);
+      if(t - head_cache > mask)
+        return false;
+    }
+
+    buffer[t & mask] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // CONSUMER: oldest item or NULL if the ring is empty
+  T* front()
+  {
+    const size_t h = head.load(std::memory_order_relaxed);
+
+    // only reload the producer index if the cached one says we are empty
+    if(h == tail_cache)
+    {
+      tail_cache = tail.load(std::memory_order_acquire);
+      if(h == tail_cache)
+        return NULL;
+    }
+
+    return &buffer[h & mask];
+  }
+
+  // CONSUMER: release the item returned by front()
+  void pop()
+  {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // CONSUMER: drop all items currently in the ring
+  void clear()
+  {
+    head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  // number of items the ring can hold
+  size_t capacity() const { return mask + 1; }
+
+private:
+
+  std::vector<T> buffer;
+  size_t mask;
+
+  // consumer side (head index and cached copy of the producer index)
+  std::atomic<size_t> head{0};
+  size_t tail_cache = 0;
+  char pad0[64];
+
+  // producer side (tail index and cached copy of the consumer index)
+  std::atomic<size_t> tail{0};
+  size_t head_cache = 0;
+  char pad1[64];
+
+};
+
+#endif // SPSC_QUEUE_H
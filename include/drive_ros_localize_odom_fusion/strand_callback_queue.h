@@ -0,0 +1,41 @@
+#ifndef STRAND_CALLBACK_QUEUE_H
+#define STRAND_CALLBACK_QUEUE_H
+
+// ros
+#include <ros/callback_queue.h>
+
+// filter core
+#include "strand_pool.h"
+
+/*
+ * ROS callback queue which is processed by a strand of a StrandPool
+ *
+ * Every callback added by roscpp (subscriptions, timers, services of the
+ * node handles using this queue) posts one task calling it to the strand,
+ * so the callbacks run serialized on the pool without a spinner. A callback
+ * which is not ready yet (TryAgain) stays in the queue and is called by the
+ * task of the next added callback.
+ *
+ */
+
+class StrandCallbackQueue : public ros::CallbackQueue
+{
+public:
+
+  explicit StrandCallbackQueue(const StrandPool::StrandPtr& s):
+    strand(s)
+  {
+  }
+
+  virtual void addCallback(const ros::CallbackInterfacePtr& callback, uint64_t removal_id = 0)
+  {
+    ros::CallbackQueue::addCallback(callback, removal_id);
+    strand->post([this]{ callOne(ros::WallDuration()); });
+  }
+
+private:
+
+  StrandPool::StrandPtr strand;
+};
+
+#endif // STRAND_CALLBACK_QUEUE_H
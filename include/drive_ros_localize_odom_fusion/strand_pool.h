@@ -0,0 +1,120 @@
+#ifndef STRAND_POOL_H
+#define STRAND_POOL_H
+
+// system
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing thread pool of serialized task sequences (strands)
+ *
+ * Tasks posted to one strand run one after another in posting order, never
+ * concurrently, but on any worker of the pool. A strand with pending tasks
+ * is queued at one worker at a time: the worker runs up to BATCH tasks of
+ * it and queues it again at its own back if more are pending. Workers take
+ * strands LIFO from their own deque (the strand just posted from a task of
+ * this worker is still in its cache) and idle workers steal FIFO from the
+ * others, so a few busy strands spread over all workers.
+ *
+ * Used to run many independent filter pipelines (one strand each) on a few
+ * threads without one thread and callback queue per pipeline.
+ *
+ */
+
+class StrandPool
+{
+public:
+
+  typedef std::function<void()> Task;
+
+  class Strand : public std::enable_shared_from_this<Strand>
+  {
+  public:
+
+    // queue a task (thread safe), it runs after all tasks posted before
+    void post(const Task& task);
+
+    // tasks not yet run
+    size_t pending();
+
+  private:
+
+    friend class StrandPool;
+
+    explicit Strand(StrandPool* pool): pool(pool) {}
+
+    StrandPool* pool;
+
+    std::mutex mutex;
+    std::deque<Task> tasks;
+
+    // queued at or run by a worker
+    bool scheduled = false;
+  };
+
+  typedef std::shared_ptr<Strand> StrandPtr;
+
+  // threads 0 = one per hardware thread (not started yet)
+  explicit StrandPool(size_t threads = 0);
+  ~StrandPool();
+
+  // new strand of this pool (the pool has to outlive it)
+  StrandPtr createStrand();
+
+  // start the workers, tasks posted before are queued until then
+  void start();
+
+  // finish the running tasks and join the workers, pending tasks stay queued
+  void stop();
+
+  size_t threads() const { return workers.size(); }
+
+  // strands taken from another worker
+  size_t stolen() const { return steals.load(std::memory_order_relaxed); }
+
+private:
+
+  // tasks of one strand run before it goes back to the queue
+  enum { BATCH = 16 };
+
+  struct Worker
+  {
+    std::mutex mutex;
+    std::deque<StrandPtr> strands;
+    std::thread thread;
+  };
+
+  // queue a strand with pending tasks
+  void schedule(const StrandPtr& strand);
+
+  // next strand for the worker (own back, then the front of the others)
+  bool take(const size_t index, StrandPtr& strand);
+
+  // run a batch of the strand's tasks
+  void runStrand(const StrandPtr& strand);
+
+  // worker loop
+  void run(const size_t index);
+
+  std::vector<std::unique_ptr<Worker> > workers;
+  std::atomic<bool> running{false};
+
+  // queued strands and sleeping workers (wakeup without lost notifications)
+  std::atomic<size_t> queued{0};
+  std::atomic<size_t> sleeping{0};
+  std::mutex idle_mutex;
+  std::condition_variable idle_cv;
+
+  // round robin worker for strands posted from outside the pool
+  std::atomic<size_t> next_worker{0};
+  std::atomic<size_t> steals{0};
+};
+
+#endif // STRAND_POOL_H
@@ -0,0 +1,96 @@
+#ifndef TRAJECTORY_COLUMNS_H
+#define TRAJECTORY_COLUMNS_H
+
+// system
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// filter core
+#include "fusion_types.h"
+
+/*
+ * Columnar trajectory file
+ *
+ * Stores the filter output as one float64 column per value, so single values,
+ * time windows or complete columns can be read from a memory mapped file
+ * without parsing.
+ *
+ * Layout (little-endian, all offsets in bytes from the file start):
+ *   Header                   (see below, padded to 4096 bytes)
+ *   columns                  COLUMNS x rows float64, column c starts at
+ *                            data_offset + c*rows*8
+ *   index                    stamp of every index_stride-th row (float64)
+ *
+ * With numpy: np.memmap(f, '<f8', 'r', data_offset, (COLUMNS, rows)) returns
+ * all columns (see scripts/trajectory_columns.py).
+ *
+ */
+
+class TrajectoryColumns
+{
+public:
+
+  // columns in file order
+  enum Column { STAMP = 0, X, Y, THETA,
+                COV_X_X, COV_X_Y, COV_X_THETA,
+                COV_Y_X, COV_Y_Y, COV_Y_THETA,
+                COV_THETA_X, COV_THETA_Y, COV_THETA_THETA,
+                COLUMNS };
+
+  struct Header
+  {
+    char     magic[8];                 // "ODOMCOL"
+    uint32_t version;
+    uint32_t columns;                  // COLUMNS
+    uint64_t rows;
+    uint64_t data_offset;
+    uint64_t index_offset;
+    uint64_t index_stride;             // rows per index entry
+    uint64_t index_size;               // number of index entries
+    char     column_names[COLUMNS][16];
+  };
+
+  TrajectoryColumns();
+  ~TrajectoryColumns();
+
+  // write a complete trajectory
+  static bool write(const std::string& filename, const std::vector<FilterOutput>& trajectory,
+                    const size_t index_stride = 1024);
+
+  // map file for reading
+  bool open(const std::string& filename);
+  void close();
+
+  // number of rows
+  size_t size() const { return rows; }
+
+  // complete column (rows values)
+  const double* column(const Column c) const { return data + c*rows; }
+
+  // single row and last row
+  void row(const size_t i, FilterOutput& out) const;
+  bool last(FilterOutput& out) const;
+
+  // rows [begin, end) with begin_stamp <= stamp < end_stamp (stamps are sorted)
+  void window(const double begin_stamp, const double end_stamp,
+              size_t& begin, size_t& end) const;
+
+private:
+
+  // first row with stamp >= t (uses the index to narrow the search)
+  size_t lowerBound(const double t) const;
+
+  void* map;
+  size_t map_size;
+
+  size_t rows;
+  const double* data;
+  const double* index;
+  size_t index_stride;
+  size_t index_size;
+
+};
+
+#endif // TRAJECTORY_COLUMNS_H
@@ -0,0 +1,73 @@
+#ifndef TRAJECTORY_LOG_H
+#define TRAJECTORY_LOG_H
+
+// system
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// filter core
+#include "fusion_types.h"
+#include "spsc_queue.h"
+
+/*
+ * Asynchronous binary log of the filter output
+ *
+ * log() only copies the output into a preallocated ring, a background thread
+ * writes the records in batches. Records which do not fit into the ring are
+ * dropped (and counted) instead of blocking the caller, unless the log was
+ * opened to wait for space.
+ *
+ * File format (host byte order):
+ *   header: char magic[8] = "ODOMLOG", uint32 version, uint32 record size
+ *   records: FilterOutput (stamp, x, y, theta, 3x3 covariance) as 13 doubles
+ *
+ * The log2csv tool converts a log into the debug_out CSV layout.
+ *
+ */
+
+class TrajectoryLog
+{
+public:
+
+  TrajectoryLog();
+  ~TrajectoryLog();
+
+  // create file and start writer thread (ring_size records are buffered,
+  // offline tools can let log() wait for space instead of dropping)
+  bool open(const std::string& filename, size_t ring_size = 4096, bool wait = false);
+
+  // write all buffered records and close the file
+  void close();
+
+  // PRODUCER: queue one record (single producer thread)
+  bool log(const FilterOutput& out);
+
+  // number of records dropped because the ring was full
+  size_t dropped() const { return dropped_records.load(std::memory_order_relaxed); }
+
+  // read a complete log file
+  static bool read(const std::string& filename, std::vector<FilterOutput>& records);
+
+private:
+
+  // writer loop
+  void run();
+
+  // move queued records to the file, returns number of records written
+  size_t flush();
+
+  SpscQueue<FilterOutput>* queue;
+  std::vector<FilterOutput> batch;
+  std::atomic<size_t> dropped_records{0};
+
+  bool wait_for_space;
+
+  int fd;
+  std::thread thread;
+  std::atomic<bool> running{false};
+
+};
+
+#endif // TRAJECTORY_LOG_H
@@ -26,6 +26,7 @@ def objective(params):
     import math
     import time
     import random
+    import sys
     import subprocess
     from hyperopt import STATUS_OK, STATUS_FAIL
     from collections import deque
@@ -39,8 +40,17 @@ def objective(params):
     path_trial_runner = path_ros_package + "/scripts/runTrial.sh"
     path_bag_file = path_ros_package + "/test/circle_002.bag"
     path_launch_file = path_ros_package + "/test/circle_002.launch"
+    path_replay = path_catkin_ws + "/devel/lib/drive_ros_localize_odom_fusion/drive_ros_localize_odom_fusion_replay"
     path_results = "/data/KalmanTuningLogs/"
 
+    # run the filter offline over the bag (no ROS master, not real time)
+    # topics have to match the ones in the launch file
+    use_replay = True
+    replay_args = ["--vehicle_model", "CTRA",
+                   "--pred_odo_topic_name", "/odom",
+                   "--pred_imu_topic_name", "/imu",
+                   "--corr_odo_topic_name", "/odom"]
+
     # TODO: make them bag specific (like: 1m error of 100m length)
     # normalize results by this values
     x_norm = 0.1 # meters
@@ -85,14 +95,20 @@ def objective(params):
     yaml.dump(config, config_out)
 
     # start trial runner
-    p = subprocess.run([path_trial_runner,
-                        "--trial", str(trial),
-                        "--logdir", path_results + str(trial),
-                        "--bag", path_bag_file,
-                        "--config", yaml_config,
-                        "--launch", path_launch_file,
-			"--timeout", str(timeout),
-                        "--catkin_ws", path_catkin_ws ], shell=False)
+    if use_replay:
+        p = subprocess.run([path_replay,
+                            "--bag", path_bag_file,
+                            "--config", yaml_config,
+                            "--out_columns", path_results + str(trial) + "/odom.col"] + replay_args, shell=False)
+    else:
+        p = subprocess.run([path_trial_runner,
+                            "--trial", str(trial),
+                            "--logdir", path_results + str(trial),
+                            "--bag", path_bag_file,
+                            "--config", yaml_config,
+                            "--launch", path_launch_file,
+                            "--timeout", str(timeout),
+                            "--catkin_ws", path_catkin_ws ], shell=False)
 
     # evaluate return code of trial runner
     if 0 == p.returncode:
@@ -104,29 +120,45 @@ def objective(params):
 
 
     # calculate loss
-    # open csv file
-    with open(path_results + str(trial) + "/odom.csv", 'r') as f:
-        try:
-            lastrow = deque(csv.reader(f), 1)[0]
-        except IndexError:  # empty file
-            lastrow = None
-
-        x = float(lastrow[1])            # x position at the end
-        y = float(lastrow[2])            # y position at the end
-        theta = float(lastrow[6])        # theta at the end
-
-        x_var = float(lastrow[7])        # x position at the end
-        y_var = float(lastrow[14])       # y position at the end
-        theta_var = float(lastrow[42])   # theta at the end
-
-
-        loss = math.sqrt( x/x_norm * x/x_norm
-                        + y/y_norm * y/y_norm
-                        + theta/theta_norm * theta/theta_norm
-                        + x_var/x_var_norm * x_var/x_var_norm
-                        + y_var/y_var_norm * y_var/y_var_norm
-                        + theta_var/theta_var_norm * theta_var/theta_var_norm )
-        print("  Loss is: " + str(loss))
+    if use_replay:
+        # columnar output: only the last values are read from the mapped file
+        sys.path.append(path_ros_package + "/scripts")
+        import trajectory_columns
+        lastrow = trajectory_columns.last(path_results + str(trial) + "/odom.col")
+
+        x = lastrow['x']                                           # x position at the end
+        y = lastrow['y']                                           # y position at the end
+        theta = math.atan2(math.sin(lastrow['theta']),
+                           math.cos(lastrow['theta']))             # theta at the end (as in the csv)
+
+        x_var = lastrow['cov_x_x']                                 # x position at the end
+        y_var = lastrow['cov_y_y']                                 # y position at the end
+        theta_var = lastrow['cov_theta_theta']                     # theta at the end
+
+    else:
+        # open csv file
+        with open(path_results + str(trial) + "/odom.csv", 'r') as f:
+            try:
+                lastrow = deque(csv.reader(f), 1)[0]
+            except IndexError:  # empty file
+                lastrow = None
+
+            x = float(lastrow[1])            # x position at the end
+            y = float(lastrow[2])            # y position at the end
+            theta = float(lastrow[6])        # theta at the end
+
+            x_var = float(lastrow[7])        # x position at the end
+            y_var = float(lastrow[14])       # y position at the end
+            theta_var = float(lastrow[42])   # theta at the end
+
+
+    loss = math.sqrt( x/x_norm * x/x_norm
+                    + y/y_norm * y/y_norm
+                    + theta/theta_norm * theta/theta_norm
+                    + x_var/x_var_norm * x_var/x_var_norm
+                    + y_var/y_var_norm * y_var/y_var_norm
+                    + theta_var/theta_var_norm * theta_var/theta_var_norm )
+    print("  Loss is: " + str(loss))
 
     # return trial results
     return {
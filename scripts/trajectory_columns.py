@@ -0,0 +1,40 @@
+"""Reader for columnar trajectory files (see include/.../trajectory_columns.h).
+
+Written by the replay tool (--out_columns) or converted from a binary debug
+log (log2csv --columns). All columns are float64 and memory mapped, nothing
+is parsed:
+
+    import trajectory_columns
+    traj = trajectory_columns.read("/tmp/odom.col")
+    traj["x"][-1], traj["cov_theta_theta"][-1]
+"""
+import struct
+import numpy as np
+
+# magic, version, columns, rows, data_offset, index_offset, index_stride, index_size
+HEADER = struct.Struct("<8sIIQQQQQ")
+NAME_SIZE = 16
+
+
+def read(path):
+    """Returns a dict column name -> numpy array (memory mapped, read only)."""
+    with open(path, "rb") as f:
+        head = f.read(HEADER.size + 64 * NAME_SIZE)
+
+    magic, version, columns, rows, data_offset, _, _, _ = HEADER.unpack_from(head)
+    if magic != b"ODOMCOL\0" or version != 1:
+        raise ValueError(path + " is not a trajectory column file (version 1)")
+
+    names = [head[HEADER.size + i * NAME_SIZE:HEADER.size + (i + 1) * NAME_SIZE]
+             .split(b"\0")[0].decode() for i in range(columns)]
+
+    if 0 == rows:
+        return {name: np.empty(0) for name in names}
+
+    data = np.memmap(path, dtype="<f8", mode="r", offset=data_offset, shape=(columns, rows))
+    return {name: data[i] for i, name in enumerate(names)}
+
+
+def last(path):
+    """Returns the last row as dict column name -> float."""
+    return {name: float(column[-1]) for name, column in read(path).items()}
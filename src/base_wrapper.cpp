@@ -1,185 +1,134 @@
 #include "drive_ros_localize_odom_fusion/base_wrapper.h"
-#include "drive_ros_localize_odom_fusion/save_odom_in_CSV.h"
 
-bool BaseWrapper::initROS()
-{
-  /*
-   * #######################
-   * Parameter and Publisher
-   * #######################
-   */
-
-  // queue for subscribers and sync policy
-  int queue_size;
-
-  // file path
-  std::string debug_out_file_path, odo_out_topic;
-
-  // ros parameters
-  pnh.param<std::string>("static_frame", static_frame, "");
-  pnh.param<std::string>("moving_frame", moving_frame, "");
-
-  pnh.param<std::string>("pred_odo_topic_name", pred_odo_topic, "");
-  pnh.param<std::string>("pred_imu_topic_name", pred_imu_topic, "");
-  pnh.param<std::string>("corr_odo_topic_name", corr_odo_topic, "");
-  pnh.param<std::string>("corr_imu_topic_name", corr_imu_topic, "");
-
-  pnh.param<std::string>("odo_out_topic", odo_out_topic, "/odom");
-
-  pnh.param<int>("queue_size", queue_size, 5);
-  pnh.param<std::string>("debug_out_file_path", debug_out_file_path, "/tmp/odom_debug.csv");
-  pnh.param<bool>("debug_out", debug_out_file, false);
-
-  float time_threshold_fl;
-  pnh.param<float>("time_threshold", time_threshold_fl, 0.5);
-  time_threshold = ros::Duration(time_threshold_fl);
-
-  // odometry publisher
-  odo_pub = nh.advertise<nav_msgs::Odometry>(odo_out_topic, 0);
-
-  // debug file
-  if(debug_out_file){
-    ROS_INFO_STREAM("Debug to file: " << debug_out_file_path);
-    SaveOdomInCSV::writeHeader(debug_out_file_path, file_out_log);
-  }
+// system
+#include <algorithm>
 
-  // init services
-  reload_proc_cov = pnh.advertiseService("reset", &BaseWrapper::svrReset, this);
-
-  /* ###########################
-   * PREDICTION subscriber setup
-   * ###########################
-   */
-
-  // only IMU data is available for prediction
-  if(pred_odo_topic.empty()){
-
-    ROS_INFO_STREAM("Setup single prediction subscriber for: " << pred_imu_topic);
-    pred_imu_single_sub = pnh.subscribe(pred_imu_topic, queue_size, &BaseWrapper::predImuCallback, this);
+void BaseWrapper::setTimeThreshold(const double threshold)
+{
+  time_threshold = threshold;
+}
 
-  // only odometry data is available for prediction
-  }else if(pred_imu_topic.empty()){
+void BaseWrapper::setLocking(const bool enabled)
+{
+  locking = enabled;
+}
 
-    ROS_INFO_STREAM("Setup single prediction subscriber for: " << pred_odo_topic);
-    pred_odo_single_sub = pnh.subscribe(pred_odo_topic, queue_size, &BaseWrapper::predOdoCallback, this);
+void BaseWrapper::setLatencyStats(LatencyStats* stats)
+{
+  latency = stats;
+}
 
-  // both odometry and IMU data are available for prediction
-  }else{
+void BaseWrapper::setExtrapolation(const bool enabled)
+{
+  extrapolation = enabled;
+}
 
-    ROS_INFO_STREAM("Setup synchronized prediction subscriber for: " << pred_odo_topic << " and " << pred_imu_topic);
-    pred_odo_sub = new message_filters::Subscriber<nav_msgs::Odometry>(pnh, pred_odo_topic, queue_size);
-    pred_imu_sub = new message_filters::Subscriber<sensor_msgs::Imu>(pnh, pred_imu_topic, queue_size);
+void BaseWrapper::setSmoother(RtsSmoother* s)
+{
+  smoother = s;
+}
 
-    // initialize policy and register sync callback
-    pred_policy = new SyncPolicy(queue_size);
-    pred_sync = new message_filters::Synchronizer<SyncPolicy>(static_cast<SyncPolicy>(*pred_policy), *pred_odo_sub, *pred_imu_sub);
-    pred_sync->registerCallback(boost::bind(&BaseWrapper::predSyncCallback, this, _1, _2));
+void BaseWrapper::lock()
+{
+  if(locking)
+    model_mutex.lock();
+}
 
-    // parameters can be found here: http://wiki.ros.org/message_filters/ApproximateTime
-    double age_penalty, odo_topic_rate, imu_topic_rate, max_time_between_imu_odo;
-    pnh.param<double>("pred_age_penalty", age_penalty, 5);
-    pnh.param<double>("pred_max_time_between_imu_odo", max_time_between_imu_odo, 0.01);
-    pnh.param<double>("pred_odo_topic_rate", odo_topic_rate, 100);
-    pnh.param<double>("pred_imu_topic_rate", imu_topic_rate, 100);
+void BaseWrapper::unlock()
+{
+  if(locking)
+    model_mutex.unlock();
+}
 
-    pred_policy->setAgePenalty(age_penalty);
-    pred_policy->setMaxIntervalDuration(ros::Duration(max_time_between_imu_odo));
+void BaseWrapper::setHistorySize(const size_t size)
+{
+  std::lock_guard<std::mutex> guard(history_mutex);
+  history.resize(size);
+  history_start = 0;
+  history_count = 0;
+}
 
-    // lower bound should be half of the time period (= double the rate) for each topic
-    pred_policy->setInterMessageLowerBound(0, ros::Rate(odo_topic_rate*2).expectedCycleTime());
-    pred_policy->setInterMessageLowerBound(1, ros::Rate(imu_topic_rate*2).expectedCycleTime());
+bool BaseWrapper::setKalmanCov(const KalmanCov& cov)
+{
+  std::string error;
+  if(!cov.valid(error))
+  {
+    FUSION_ERROR_STREAM("Invalid kalman_cov: " << error << ". Keeping the previous values.");
+    return false;
   }
 
-  /* ###########################
-   * CORRECTION subscriber setup
-   * ###########################
-   */
-
-  // only IMU data is available for correction
-  if(corr_odo_topic.empty()){
-
-    ROS_INFO_STREAM("Setup single correction subscriber for: " << corr_imu_topic);
-    corr_imu_single_sub = pnh.subscribe(corr_imu_topic, queue_size, &BaseWrapper::corrImuCallback, this);
-
-  // only odometry data is available for correction
-  }else if(corr_imu_topic.empty()){
-
-    ROS_INFO_STREAM("Setup single correction subscriber for: " << corr_odo_topic);
-    corr_odo_single_sub = pnh.subscribe(corr_odo_topic, queue_size, &BaseWrapper::corrOdoCallback, this);
-
-  // both odometry and IMU data are available for correction
-  }else{
-
-    ROS_INFO_STREAM("Setup synchronized correction subscriber for: " << corr_odo_topic << " and " << corr_imu_topic);
-    corr_odo_sub = new message_filters::Subscriber<nav_msgs::Odometry>(pnh, corr_odo_topic, queue_size);
-    corr_imu_sub = new message_filters::Subscriber<sensor_msgs::Imu>(pnh, corr_imu_topic, queue_size);
-
-    // initialize policy and register sync callback
-    corr_policy = new SyncPolicy(queue_size);
-    corr_sync = new message_filters::Synchronizer<SyncPolicy>(static_cast<SyncPolicy>(*corr_policy), *corr_odo_sub, *corr_imu_sub);
-    corr_sync->registerCallback(boost::bind(&BaseWrapper::corrSyncCallback, this, _1, _2));
-
-    // parameters can be found here: http://wiki.ros.org/message_filters/ApproximateTime
-    double age_penalty, odo_topic_rate, imu_topic_rate, max_time_between_imu_odo;
-    pnh.param<double>("corr_age_penalty", age_penalty, 5);
-    pnh.param<double>("corr_max_time_between_imu_odo", max_time_between_imu_odo, 0.1);
-    pnh.param<double>("corr_odo_topic_rate", odo_topic_rate, 100);
-    pnh.param<double>("corr_imu_topic_rate", imu_topic_rate, 100);
+  std::atomic_store(&kalman_cov, std::make_shared<const KalmanCov>(cov));
+  kalman_cov_version.fetch_add(1, std::memory_order_release);
+  return true;
+}
 
-    corr_policy->setAgePenalty(age_penalty);
-    corr_policy->setMaxIntervalDuration(ros::Duration(max_time_between_imu_odo));
+std::shared_ptr<const KalmanCov> BaseWrapper::getKalmanCov() const
+{
+  return std::atomic_load(&kalman_cov);
+}
 
-    // lower bound should be half of the time period (= double the rate) for each topic
-    corr_policy->setInterMessageLowerBound(0, ros::Rate(odo_topic_rate*2).expectedCycleTime());
-    corr_policy->setInterMessageLowerBound(1, ros::Rate(imu_topic_rate*2).expectedCycleTime());
-  }
+bool BaseWrapper::reset()
+{
+  std::unique_lock<std::mutex> guard(history_mutex, std::defer_lock);
+  if(locking)
+    guard.lock();
 
-  // reset filter
-  return reset();
+  history_start = 0;
+  history_count = 0;
+  return resetFilter();
+}
 
+bool BaseWrapper::resetFilter()
+{
+  lock();
+  const bool ret = resetFilterLocked();
+  unlock();
+  return ret;
 }
 
-bool BaseWrapper::reset()
+bool BaseWrapper::resetFilterLocked()
 {
-  ROS_INFO("Reset Kalman Filter");
+  FUSION_INFO("Reset Kalman Filter");
 
   // reset times
-  pred_last_timestamp = ros::Time(0);
-  pred_last_delta     = ros::Duration(0);
-  corr_last_timestamp = ros::Time(0);
-  corr_last_delta     = ros::Duration(0);
+  pred_last_timestamp = 0;
+  pred_last_delta     = 0;
+  corr_last_timestamp = 0;
+  corr_last_delta     = 0;
+
+  // newest covariance snapshot (version first, a newer snapshot is applied later)
+  const unsigned version = kalman_cov_version.load(std::memory_order_acquire);
+  const std::shared_ptr<const KalmanCov> cov = getKalmanCov();
 
   // reset covariances and filter state
-  model_mutex.lock();
   predict_since_last_correct = false;
-  bool ret = initFilterState();
-  model_mutex.unlock();
-  return ret;
-}
+  bool ret = initFilterState(*cov);
+  applied_cov_version = version;
+  if(smoother) smoother->startChain();
 
-// reload process covariances
-bool BaseWrapper::svrReset(std_srvs::Trigger::Request  &req,
-                           std_srvs::Trigger::Response &res)
-{
-  res.message = "Reset Kalman Filter.";
-  return res.success = reset();
+  // no state to extrapolate until the next prediction
+  snapshot_mutex.lock();
+  snapshot_timestamp = 0;
+  snapshot_mutex.unlock();
+
+  return ret;
 }
 
 // process timestamp and deltas
-bool BaseWrapper::processTimestamp(ros::Time& last_t, ros::Time& curr_t,
-                                   ros::Duration& last_d, ros::Duration& curr_d) const
+bool BaseWrapper::processTimestamp(double& last_t, double& curr_t,
+                                   double& last_d, double& curr_d) const
 {
   // check if current time is ok
-  if(ros::Time(0) == curr_t)
+  if(0 == curr_t)
   {
-    ROS_ERROR("Current timestamp is 0. Aborting.");
+    FUSION_ERROR("Current timestamp is 0. Aborting.");
     return false;
   }
 
   // check if this is first loop or reinitialized
-  if(ros::Time(0) == last_t){
-    ROS_INFO("Last timestamp is 0. Using time_threshold/5 as delta.");
-    curr_d = ros::Duration(time_threshold.toSec()/5); // use some value for first current delta
+  if(0 == last_t){
+    FUSION_INFO("Last timestamp is 0. Using time_threshold/5 as delta.");
+    curr_d = time_threshold/5; // use some value for first current delta
     last_t = curr_t - curr_d; // use some value for first last timestamp
     return true;
   }else{
@@ -189,7 +138,7 @@ bool BaseWrapper::processTimestamp(ros::Time& last_t, ros::Time& curr_t,
   // time jump to big -> reset filter
   if(curr_d > time_threshold){
 
-    ROS_ERROR_STREAM("Delta Time Threshold exceeded. Reinit Filter."
+    FUSION_ERROR_STREAM("Delta Time Threshold exceeded. Reinit Filter."
         << " delta = " << curr_d
         << " thres = " << time_threshold
         << " lastTime = " << last_t
@@ -198,8 +147,8 @@ bool BaseWrapper::processTimestamp(ros::Time& last_t, ros::Time& curr_t,
    return false;
 
   // jumping back in time
-  }else if(curr_d <= ros::Duration(0)) {
-      ROS_WARN_STREAM("Jumping back in time. Delta = " << curr_d <<
+  }else if(curr_d <= 0) {
+      FUSION_WARN_STREAM("Jumping back in time. Delta = " << curr_d <<
                        " old_time = " << last_t <<
                        " cur_time = " << curr_t);
 
@@ -215,141 +164,323 @@ bool BaseWrapper::processTimestamp(ros::Time& last_t, ros::Time& curr_t,
   return true;
 }
 
-void BaseWrapper::predOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo)
-{
-  // predict and output messages
-  processPredictionData(msg_odo->header.stamp, msg_odo, NULL);
-}
-
-void BaseWrapper::predImuCallback(const sensor_msgs::ImuConstPtr &msg_imu)
-{
-  // predict and output messages
-  processPredictionData(msg_imu->header.stamp, NULL, msg_imu);
-}
-
-void BaseWrapper::predSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,
-                                   const sensor_msgs::ImuConstPtr &msg_imu)
-{
-  // predict and output messages
-  processPredictionData(ros::Time((msg_imu->header.stamp.toSec() + msg_odo->header.stamp.toSec())/2.0),
-                        msg_odo, msg_imu);
-}
-
-bool BaseWrapper::processPredictionData(ros::Time current_timestamp,
-                                        const nav_msgs::OdometryConstPtr &msg_odo,
-                                        const sensor_msgs::ImuConstPtr &msg_imu)
+bool BaseWrapper::predictStep(double current_timestamp,
+                              const OdoData* odo,
+                              const ImuData* imu,
+                              FilterOutput& out,
+                              const bool output)
 {
   // current delta
-  ros::Duration current_delta;
+  double current_delta;
+
+  // timestamps belong to the filter state (model mutex)
+  uint64_t t = latency ? LatencyStats::now() : 0;
+  lock();
+  if(latency) t = latency->lap(LatencyStats::MUTEX_WAIT, t);
 
   // process timestamp
   if(!processTimestamp(pred_last_timestamp, current_timestamp,
                        pred_last_delta, current_delta))
   {
-    ROS_ERROR("Process prediction timestamp failed!");
-    reset();
+    FUSION_ERROR("Process prediction timestamp failed!");
+    resetFilterLocked();
+    unlock();
     return false;
   }
 
-  // create output messages
-  geometry_msgs::TransformStamped tf;
-  nav_msgs::Odometry odom;
-
   // do the prediction
-  model_mutex.lock();
-  if(!predict(current_delta.toSec(), msg_odo, msg_imu))
+
+  // reloaded covariances
+  const unsigned version = kalman_cov_version.load(std::memory_order_acquire);
+  if(version != applied_cov_version)
   {
-    ROS_ERROR("Prediction step failed!");
-    model_mutex.unlock();
-    reset();
+    FUSION_INFO("Apply reloaded process noise.");
+    setProcessNoise(*getKalmanCov());
+    applied_cov_version = version;
+  }
+
+  if(!predict(current_delta, odo, imu))
+  {
+    FUSION_ERROR("Prediction step failed!");
+    resetFilterLocked();
+    unlock();
     return false;
   }
+  if(latency) t = latency->lap(LatencyStats::PREDICT, t);
 
   predict_since_last_correct = true;
+  if(smoother) recordStep(*smoother, current_timestamp, false);
 
-  // get output from wrapper
-  getOutput(tf, odom);
-  model_mutex.unlock();
-
-  // set frames
-  tf.header.frame_id = static_frame;
-  tf.child_frame_id =  moving_frame;
-  odom.header.frame_id = static_frame;
-  odom.child_frame_id =  moving_frame;
+  // get output from wrapper (only if it is published)
+  if(output)
+  {
+    getOutput(out);
+    if(latency) latency->lap(LatencyStats::GET_OUTPUT, t);
+  }
+  updateSnapshot();
+  unlock();
 
   // set output time
-  tf.header.stamp = current_timestamp;
-  odom.header.stamp = current_timestamp;
+  out.stamp = current_timestamp;
 
-  // publish
-  odo_pub.publish(odom);
-  br.sendTransform(tf);
+  return true;
+}
 
-  // debug to file
-  if(debug_out_file)
+bool BaseWrapper::correctStep(double current_timestamp,
+                              const OdoData* odo,
+                              const ImuData* imu)
+{
+  // current delta
+  double current_delta;
+
+  // timestamps belong to the filter state (model mutex)
+  uint64_t t = latency ? LatencyStats::now() : 0;
+  lock();
+  if(latency) t = latency->lap(LatencyStats::MUTEX_WAIT, t);
+
+  // process timestamp
+  if(!processTimestamp(corr_last_timestamp, current_timestamp,
+                       corr_last_delta, current_delta))
   {
-    SaveOdomInCSV::writeMsg(odom, file_out_log);
+    FUSION_ERROR("Process correction timestamp failed!");
+    resetFilterLocked();
+    unlock();
+    return false;
   }
 
+  // do the correction
+
+  // check if we already predicted
+  if(predict_since_last_correct)
+  {
+    predict_since_last_correct = false;
+
+    if(!correct(current_delta, odo, imu))
+    {
+      FUSION_ERROR("Correction step failed!");
+      resetFilterLocked();
+      unlock();
+      return false;
+    }
+    if(latency) latency->lap(LatencyStats::CORRECT, t);
+    if(smoother) recordStep(*smoother, current_timestamp, true);
+    updateSnapshot();
+  }
+  unlock();
   return true;
 }
 
+bool BaseWrapper::processPredictionData(double current_timestamp,
+                                        const OdoData* odo,
+                                        const ImuData* imu,
+                                        FilterOutput& out,
+                                        const bool output)
+{
+  // no history -> process as it comes
+  if(history.empty())
+  {
+    return predictStep(current_timestamp, odo, imu, out, output);
+  }
+
+  FilterSample sample;
+  sample.stamp   = current_timestamp;
+  sample.has_odo = (NULL != odo);
+  sample.has_imu = (NULL != imu);
+  if(odo) sample.odo = *odo;
+  if(imu) sample.imu = *imu;
 
-void BaseWrapper::corrOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo)
+  return processSample(false, sample, out, output);
+}
+
+bool BaseWrapper::processCorrectionData(double current_timestamp,
+                                        const OdoData* odo,
+                                        const ImuData* imu)
 {
-  // correct
-  processCorrectionData(msg_odo->header.stamp, msg_odo, NULL);
+  // no history -> process as it comes
+  if(history.empty())
+  {
+    return correctStep(current_timestamp, odo, imu);
+  }
+
+  FilterSample sample;
+  sample.stamp   = current_timestamp;
+  sample.has_odo = (NULL != odo);
+  sample.has_imu = (NULL != imu);
+  if(odo) sample.odo = *odo;
+  if(imu) sample.imu = *imu;
+
+  FilterOutput out;
+  return processSample(true, sample, out, false);
 }
 
-void BaseWrapper::corrImuCallback(const sensor_msgs::ImuConstPtr &msg_imu)
+void BaseWrapper::updateSnapshot()
 {
-  // correct
-  processCorrectionData(msg_imu->header.stamp, NULL, msg_imu);
+  if(!extrapolation)
+    return;
+
+  // corrections do not move the state in time, it stays at the last prediction
+  snapshot_mutex.lock();
+  saveSnapshot();
+  snapshot_timestamp = pred_last_timestamp;
+  snapshot_mutex.unlock();
 }
 
-void BaseWrapper::corrSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,
-                                   const sensor_msgs::ImuConstPtr &msg_imu)
+bool BaseWrapper::extrapolate(double timestamp, FilterOutput& out)
 {
-  // correct
-  processCorrectionData(ros::Time((msg_imu->header.stamp.toSec() + msg_odo->header.stamp.toSec())/2.0),
-                        msg_odo, msg_imu);
+  std::lock_guard<std::mutex> guard(snapshot_mutex);
+
+  if(0 == snapshot_timestamp)
+    return false;
+
+  // the snapshot may be newer than the requested time, then it is output as it is
+  const double dt = std::max(0.0, timestamp - snapshot_timestamp);
+  if(dt > time_threshold)
+  {
+    return false;
+  }
+
+  if(!extrapolateSnapshot(dt, out))
+  {
+    return false;
+  }
+
+  out.stamp = std::max(timestamp, snapshot_timestamp);
+  return true;
 }
 
-bool BaseWrapper::processCorrectionData(ros::Time current_timestamp,
-                                        const nav_msgs::OdometryConstPtr &msg_odo,
-                                        const sensor_msgs::ImuConstPtr &msg_imu)
+bool BaseWrapper::processSample(const bool correction, const FilterSample& sample,
+                                FilterOutput& out, const bool output)
 {
-  // current delta
-  ros::Duration current_delta;
+  std::unique_lock<std::mutex> guard(history_mutex, std::defer_lock);
+  if(locking)
+    guard.lock();
 
-  // process timestamp
-  if(!processTimestamp(corr_last_timestamp, current_timestamp,
-                       corr_last_delta, current_delta))
+  // late sample -> apply at its true time and re-propagate the newer steps
+  if(history_count > 0 && sample.stamp < historyAt(history_count - 1).sample.stamp)
+  {
+    // the newest output keeps its time, so a late prediction has nothing new to publish
+    return insertLateSample(correction, sample) && correction;
+  }
+
+  const OdoData* odo = sample.has_odo ? &sample.odo : NULL;
+  const ImuData* imu = sample.has_imu ? &sample.imu : NULL;
+
+  const bool ok = correction ? correctStep(sample.stamp, odo, imu)
+                             : predictStep(sample.stamp, odo, imu, out, output);
+  if(!ok)
   {
-    ROS_ERROR("Process correction timestamp failed!");
-    reset();
+    history_count = 0;
     return false;
   }
 
-  // do the correction
-  model_mutex.lock();
+  // remember step
+  HistoryEntry& entry = appendHistory();
+  entry.correction = correction;
+  entry.sample = sample;
+  saveHistory(entry);
 
-  // check if we already predicted
-  if(predict_since_last_correct)
+  return true;
+}
+
+bool BaseWrapper::insertLateSample(const bool correction, const FilterSample& sample)
+{
+  // newest entry which is not newer than the sample
+  size_t k = history_count;
+  while(k > 0 && historyAt(k - 1).sample.stamp > sample.stamp)
   {
-    predict_since_last_correct = false;
+    k--;
+  }
+
+  if(0 == k)
+  {
+    FUSION_WARN_STREAM("Sample older than history. Dropping it."
+                       << " stamp = " << sample.stamp
+                       << " oldest = " << historyAt(0).sample.stamp);
+    return false;
+  }
+
+  FUSION_DEBUG_STREAM("Late " << (correction ? "correction" : "prediction")
+                      << ", re-propagating " << history_count - k << " steps.");
 
-    if(!correct(current_delta.toSec(), msg_odo, msg_imu))
+  // rewind to the state before the sample
+  restoreHistory(historyAt(k - 1));
+
+  // make room at position k (drops the oldest entry if the ring is full)
+  if(history_count == history.size())
+  {
+    history_start = (history_start + 1) % history.size();
+    history_count--;
+    k--;
+  }
+  history_count++;
+  for(size_t i = history_count - 1; i > k; i--)
+  {
+    historyAt(i) = historyAt(i - 1);
+  }
+
+  HistoryEntry& entry = historyAt(k);
+  entry.correction = correction;
+  entry.sample = sample;
+
+  // apply the late sample and redo all newer steps (their outputs are not published)
+  FilterOutput out;
+  for(size_t i = k; i < history_count; i++)
+  {
+    HistoryEntry& step = historyAt(i);
+    const OdoData* odo = step.sample.has_odo ? &step.sample.odo : NULL;
+    const ImuData* imu = step.sample.has_imu ? &step.sample.imu : NULL;
+
+    const bool ok = step.correction ? correctStep(step.sample.stamp, odo, imu)
+                                    : predictStep(step.sample.stamp, odo, imu, out, false);
+    if(!ok)
     {
-      ROS_ERROR("Correction step failed!");
-      model_mutex.unlock();
-      reset();
+      history_count = 0;
       return false;
     }
+
+    saveHistory(step);
   }
-  model_mutex.unlock();
+
   return true;
 }
 
+BaseWrapper::HistoryEntry& BaseWrapper::historyAt(const size_t i)
+{
+  return history[(history_start + i) % history.size()];
+}
+
+BaseWrapper::HistoryEntry& BaseWrapper::appendHistory()
+{
+  // overwrite the oldest entry if the ring is full
+  if(history_count == history.size())
+  {
+    history_start = (history_start + 1) % history.size();
+    history_count--;
+  }
+  return historyAt(history_count++);
+}
 
+void BaseWrapper::saveHistory(HistoryEntry& entry)
+{
+  lock();
+  entry.state.size = 0;
+  saveState(entry.state);
+  entry.predict_since_last_correct = predict_since_last_correct;
+  entry.pred_last_timestamp = pred_last_timestamp;
+  entry.pred_last_delta     = pred_last_delta;
+  entry.corr_last_timestamp = corr_last_timestamp;
+  entry.corr_last_delta     = corr_last_delta;
+  unlock();
+}
 
+void BaseWrapper::restoreHistory(const HistoryEntry& entry)
+{
+  lock();
+  restoreState(entry.state);
+  predict_since_last_correct = entry.predict_since_last_correct;
+  pred_last_timestamp = entry.pred_last_timestamp;
+  pred_last_delta     = entry.pred_last_delta;
+  corr_last_timestamp = entry.corr_last_timestamp;
+  corr_last_delta     = entry.corr_last_delta;
+  unlock();
+}
@@ -0,0 +1,317 @@
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/replay_events.h"
+#include "drive_ros_localize_odom_fusion/replay_args.h"
+
+/*
+ * Batch evaluation of covariance configurations
+ *
+ * Decodes the bag once and runs one filter per configuration over the same
+ * events on a pool of threads. Each configuration is a row of a CSV file
+ * whose header names kalman_cov parameters, missing parameters are taken
+ * from the vehicle config:
+ *
+ *   sys_var_x,sys_var_y,sys_var_theta
+ *   0.001,0.001,0.01
+ *   ...
+ *
+ * The loss is the one of scripts/kalmanTuning.py (pose and variance at the
+ * end of the bag, normalized). The result CSV repeats the configuration
+ * columns and adds the metrics.
+ *
+ */
+
+using namespace Replay;
+
+// print help and exit
+static int help()
+{
+  std::cout << "Use the following arguments:" << std::endl
+            << "  --bag <bagfile>                 (required)" << std::endl
+            << "  --config <vehicle_config>       (required, default values)" << std::endl
+            << "  --configs <csv_file>            (required, one configuration per row)" << std::endl
+            << "  --out <csv_file>                (required, loss per configuration)" << std::endl
+            << "  --threads <n>                   (default: number of cores)" << std::endl
+            << "  --vehicle_model <" << ModelRegistry::names() << ">     (default: " << ModelRegistry::defaultName() << ")" << std::endl
+            << "  --[x|y|theta]_norm, --[x|y|theta]_var_norm  (loss normalization)" << std::endl
+            << "  topic, synchronizer and filter arguments as for the replay tool" << std::endl;
+  return 1;
+}
+
+// kalman_cov parameter names
+static double KalmanCov::* covMember(const std::string& name)
+{
+  if("filter_init_var_x"     == name) return &KalmanCov::filter_init_var_x;
+  if("filter_init_var_y"     == name) return &KalmanCov::filter_init_var_y;
+  if("filter_init_var_theta" == name) return &KalmanCov::filter_init_var_theta;
+  if("sys_var_x"             == name) return &KalmanCov::sys_var_x;
+  if("sys_var_y"             == name) return &KalmanCov::sys_var_y;
+  if("sys_var_theta"         == name) return &KalmanCov::sys_var_theta;
+  return NULL;
+}
+
+// split one csv line
+static std::vector<std::string> splitLine(const std::string& line)
+{
+  std::vector<std::string> cells;
+  std::istringstream ss(line);
+  std::string cell;
+  while(std::getline(ss, cell, ','))
+  {
+    cells.push_back(cell);
+  }
+  return cells;
+}
+
+// read configurations (header = parameter names)
+static bool loadConfigs(const std::string& file, const KalmanCov& defaults,
+                        std::vector<std::string>& names, std::vector<KalmanCov>& configs)
+{
+  std::ifstream in(file);
+  std::string line;
+  if(!std::getline(in, line))
+  {
+    ROS_ERROR_STREAM("Reading " << file << " failed.");
+    return false;
+  }
+
+  names = splitLine(line);
+  std::vector<double KalmanCov::*> members;
+  for(const std::string& name : names)
+  {
+    members.push_back(covMember(name));
+    if(NULL == members.back())
+    {
+      ROS_ERROR_STREAM("Unknown kalman_cov parameter: " << name);
+      return false;
+    }
+  }
+
+  while(std::getline(in, line))
+  {
+    if(line.empty())
+      continue;
+
+    std::vector<std::string> cells = splitLine(line);
+    if(cells.size() != members.size())
+    {
+      ROS_ERROR_STREAM("Invalid configuration: " << line);
+      return false;
+    }
+
+    KalmanCov cov = defaults;
+    try
+    {
+      for(size_t i = 0; i < cells.size(); i++)
+      {
+        cov.*members[i] = std::stod(cells[i]);
+      }
+    }
+    catch(const std::exception&)
+    {
+      ROS_ERROR_STREAM("Invalid configuration: " << line);
+      return false;
+    }
+    configs.push_back(cov);
+  }
+  return true;
+}
+
+// result of one configuration
+struct Result
+{
+  bool   ok = false;
+  size_t outputs = 0;
+
+  // last output
+  double x = 0, y = 0, theta = 0;
+  double x_var = 0, y_var = 0, theta_var = 0;
+
+  double loss = 0;
+};
+
+struct Norms
+{
+  double x = 0.1, y = 0.1, theta = 0.1;
+  double x_var = 1.0, y_var = 1.0, theta_var = 0.34;
+};
+
+int main(int argc, char **argv)
+{
+  // parse "--key value" arguments
+  Args args;
+  if(!parseArgs(argc, argv, args))
+  {
+    return help();
+  }
+
+  if(!args.count("bag") || !args.count("config") || !args.count("configs") || !args.count("out"))
+  {
+    return help();
+  }
+
+  // message filters use ros::Time::now() as receipt time
+  ros::Time::init();
+
+  const std::string vehicle_model = param<std::string>(args, "vehicle_model", ModelRegistry::defaultName());
+  if(!std::unique_ptr<BaseWrapper>(ModelRegistry::create(vehicle_model)))
+  {
+    ROS_ERROR_STREAM("Invalid vehicle model: " << vehicle_model);
+    return 1;
+  }
+
+  // configurations
+  KalmanCov defaults;
+  std::vector<std::string> names;
+  std::vector<KalmanCov> configs;
+  if(!loadKalmanCov(args["config"], defaults) ||
+     !loadConfigs(args["configs"], defaults, names, configs))
+  {
+    return 2;
+  }
+
+  // result file (opened before the evaluation to fail early)
+  std::ofstream result_file(args["out"]);
+  if(!result_file)
+  {
+    ROS_ERROR_STREAM("Opening " << args["out"] << " failed.");
+    return 2;
+  }
+
+  Norms norms;
+  norms.x         = param<double>(args, "x_norm", norms.x);
+  norms.y         = param<double>(args, "y_norm", norms.y);
+  norms.theta     = param<double>(args, "theta_norm", norms.theta);
+  norms.x_var     = param<double>(args, "x_var_norm", norms.x_var);
+  norms.y_var     = param<double>(args, "y_var_norm", norms.y_var);
+  norms.theta_var = param<double>(args, "theta_var_norm", norms.theta_var);
+
+  const double time_threshold = param<double>(args, "time_threshold", 0.5);
+  const int history_size = param<int>(args, "history_size", 0);
+
+  int threads = param<int>(args, "threads", static_cast<int>(std::thread::hardware_concurrency()));
+  threads = std::max(1, threads);
+
+  // decode bag once
+  Replay::Config config;
+  loadConfig(args, config);
+
+  auto t_start = std::chrono::steady_clock::now();
+
+  std::vector<Replay::Event> events;
+  if(!Replay::loadEvents(args["bag"], config, events))
+  {
+    return 3;
+  }
+
+  auto t_loaded = std::chrono::steady_clock::now();
+
+  // only show problems of the single runs
+  FusionLog::setLevel(FusionLog::Error);
+
+  // evaluate configurations on all threads
+  std::vector<Result> results(configs.size());
+  std::atomic<size_t> next{0};
+
+  auto worker = [&]()
+  {
+    for(size_t i = next++; i < configs.size(); i = next++)
+    {
+      std::unique_ptr<BaseWrapper> model(ModelRegistry::create(vehicle_model));
+
+      // invalid configurations are reported as not ok
+      if(!model->setKalmanCov(configs[i]))
+        continue;
+      model->setTimeThreshold(time_threshold);
+      model->setHistorySize(history_size);
+
+      // a single thread uses each model
+      model->setLocking(false);
+
+      Result& r = results[i];
+      FilterOutput last;
+      if(!model->reset())
+        continue;
+
+      r.outputs = Replay::run(*model, events, [&last](const FilterOutput& out){ last = out; });
+      if(0 == r.outputs)
+        continue;
+
+      // same values as read from the csv by kalmanTuning.py
+      r.x         = last.x;
+      r.y         = last.y;
+      r.theta     = std::atan2(std::sin(last.theta), std::cos(last.theta));
+      r.x_var     = last.covariance[0];
+      r.y_var     = last.covariance[4];
+      r.theta_var = last.covariance[8];
+
+      r.loss = std::sqrt(std::pow(r.x/norms.x, 2)
+                       + std::pow(r.y/norms.y, 2)
+                       + std::pow(r.theta/norms.theta, 2)
+                       + std::pow(r.x_var/norms.x_var, 2)
+                       + std::pow(r.y_var/norms.y_var, 2)
+                       + std::pow(r.theta_var/norms.theta_var, 2));
+      r.ok = std::isfinite(r.loss);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(int t = 0; t < threads; t++)
+  {
+    pool.push_back(std::thread(worker));
+  }
+  for(std::thread& t : pool)
+  {
+    t.join();
+  }
+
+  auto t_done = std::chrono::steady_clock::now();
+
+  // write results
+  result_file.precision(10);
+  for(const std::string& name : names)
+  {
+    result_file << name << ",";
+  }
+  result_file << "ok,outputs,x,y,theta,x_var,y_var,theta_var,loss\n";
+
+  for(size_t i = 0; i < configs.size(); i++)
+  {
+    for(const std::string& name : names)
+    {
+      result_file << configs[i].*covMember(name) << ",";
+    }
+
+    const Result& r = results[i];
+    result_file << r.ok << "," << r.outputs << ","
+                << r.x << "," << r.y << "," << r.theta << ","
+                << r.x_var << "," << r.y_var << "," << r.theta_var << ","
+                << r.loss << "\n";
+  }
+
+  result_file.close();
+  if(result_file.fail())
+  {
+    ROS_ERROR_STREAM("Writing " << args["out"] << " failed.");
+    return 2;
+  }
+
+  const double filter_time = std::chrono::duration<double>(t_done - t_loaded).count();
+  std::cout << "Evaluated " << configs.size() << " configurations over " << events.size() << " filter steps"
+            << " with " << threads << " threads."
+            << " load: " << std::chrono::duration<double>(t_loaded - t_start).count() << "s"
+            << " filter: " << filter_time << "s"
+            << " (" << configs.size()/filter_time << " configurations/s)" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include "drive_ros_localize_odom_fusion/filter_thread.h"
+
+// system
+#include <chrono>
+
+FilterThread::FilterThread(BaseWrapper* m, size_t queue_size, const OutputCallback& out,
+                           const OutputDueCallback& due):
+  model(m), output(out), output_due(due), pred_queue(queue_size), corr_queue(queue_size)
+{
+}
+
+FilterThread::~FilterThread()
+{
+  stop();
+}
+
+void FilterThread::start()
+{
+  if(running.exchange(true))
+    return;
+
+  // the filter thread is the only user of the model from now on
+  model->setLocking(false);
+  thread = std::thread(&FilterThread::run, this);
+}
+
+void FilterThread::stop()
+{
+  if(!running.exchange(false))
+    return;
+
+  notify();
+  thread.join();
+  model->setLocking(true);
+}
+
+bool FilterThread::pushPrediction(const FilterSample& sample)
+{
+  if(!pred_queue.push(sample))
+  {
+    dropped_pred.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  notify();
+  return true;
+}
+
+bool FilterThread::pushCorrection(const FilterSample& sample)
+{
+  if(!corr_queue.push(sample))
+  {
+    dropped_corr.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  notify();
+  return true;
+}
+
+void FilterThread::requestReset()
+{
+  reset_requested.store(true);
+  notify();
+}
+
+void FilterThread::notify()
+{
+  // pairs with the fence in run(): either the consumer sees the new sample
+  // or we see that it is waiting and wake it up
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(waiting.load(std::memory_order_relaxed))
+  {
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    wait_cv.notify_one();
+  }
+}
+
+void FilterThread::run()
+{
+  FilterOutput out;
+
+  while(running.load(std::memory_order_relaxed))
+  {
+    // reset between two samples
+    if(reset_requested.exchange(false))
+    {
+      model->reset();
+    }
+
+    FilterSample* pred = pred_queue.front();
+    FilterSample* corr = corr_queue.front();
+
+    // nothing to do -> wait for the next sample
+    if(!pred && !corr)
+    {
+      std::unique_lock<std::mutex> lock(wait_mutex);
+      waiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if(!pred_queue.front() && !corr_queue.front() &&
+         !reset_requested.load() && running.load())
+      {
+        // the timeout only guards against a stop without notify
+        wait_cv.wait_for(lock, std::chrono::milliseconds(100));
+      }
+      waiting.store(false, std::memory_order_relaxed);
+      continue;
+    }
+
+    // consume the older sample first (corrections win on equal stamps)
+    if(corr && (!pred || corr->stamp <= pred->stamp))
+    {
+      model->processCorrectionData(corr->stamp,
+                                   corr->has_odo ? &corr->odo : NULL,
+                                   corr->has_imu ? &corr->imu : NULL);
+      corr_queue.pop();
+    }
+    else
+    {
+      const int outputs = output_due ? output_due(pred->stamp) : -1;
+      if(model->processPredictionData(pred->stamp,
+                                      pred->has_odo ? &pred->odo : NULL,
+                                      pred->has_imu ? &pred->imu : NULL,
+                                      out, 0 != outputs) && 0 != outputs)
+      {
+        output(out, outputs);
+      }
+      pred_queue.pop();
+    }
+  }
+}
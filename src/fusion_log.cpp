@@ -0,0 +1,40 @@
+#include "drive_ros_localize_odom_fusion/fusion_log.h"
+
+// system
+#include <atomic>
+#include <iostream>
+
+namespace FusionLog {
+
+static std::atomic<Handler> log_handler(nullptr);
+static std::atomic<int>     log_level(Info);
+
+void setHandler(Handler handler)
+{
+  log_handler = handler;
+}
+
+void setLevel(Level level)
+{
+  log_level = level;
+}
+
+bool enabled(Level level)
+{
+  return level >= log_level;
+}
+
+void write(Level level, const std::string& msg)
+{
+  Handler handler = log_handler;
+
+  if(handler){
+    handler(level, msg);
+    return;
+  }
+
+  static const char* names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+  std::cerr << "[" << names[level] << "] " << msg << std::endl;
+}
+
+} // namespace FusionLog
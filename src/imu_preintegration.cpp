@@ -0,0 +1,83 @@
+#include "drive_ros_localize_odom_fusion/imu_preintegration.h"
+
+// system
+#include <algorithm>
+
+ImuPreintegration::ImuPreintegration(const double w):
+  window(w)
+{
+}
+
+void ImuPreintegration::setWindow(const double w)
+{
+  window = w;
+  reset();
+}
+
+void ImuPreintegration::reset()
+{
+  last_stamp    = 0;
+  release_stamp = 0;
+  pending       = 0;
+  sum_dt        = 0;
+  sum_omega     = 0;
+  sum_acc       = 0;
+  sum_vx        = 0;
+  sum_vy        = 0;
+}
+
+bool ImuPreintegration::add(const FilterSample& sample, FilterSample& out)
+{
+  // first sample has no interval, it starts the filter as it is
+  if(0 == last_stamp || 0 == window)
+  {
+    last_stamp = release_stamp = sample.stamp;
+    out = sample;
+    return true;
+  }
+
+  // samples back in time do not add to the integral
+  const double dt = sample.stamp > last_stamp ? sample.stamp - last_stamp : 0;
+  last_stamp = std::max(last_stamp, sample.stamp);
+
+  sum_dt    += dt;
+  sum_omega += dt*sample.imu.angular_velocity_z;
+  sum_acc   += dt*sample.imu.linear_acceleration_x;
+  sum_vx    += dt*sample.odo.linear_velocity_x;
+  sum_vy    += dt*sample.odo.linear_velocity_y;
+  newest = sample;
+  pending += std::max(1u, sample.imu.samples);
+
+  // tolerance for the jitter of the sample stamps
+  if(last_stamp - release_stamp < window*0.999)
+    return false;
+
+  return flush(out);
+}
+
+bool ImuPreintegration::flush(FilterSample& out)
+{
+  if(0 == pending)
+    return false;
+
+  out = newest;
+  out.stamp = last_stamp;
+  if(sum_dt > 0)
+  {
+    out.imu.angular_velocity_z    = sum_omega/sum_dt;
+    out.imu.linear_acceleration_x = sum_acc/sum_dt;
+    out.odo.linear_velocity_x     = sum_vx/sum_dt;
+    out.odo.linear_velocity_y     = sum_vy/sum_dt;
+  }
+  out.imu.stamp   = last_stamp;
+  out.imu.samples = pending;
+
+  release_stamp = last_stamp;
+  pending   = 0;
+  sum_dt    = 0;
+  sum_omega = 0;
+  sum_acc   = 0;
+  sum_vx    = 0;
+  sum_vy    = 0;
+  return true;
+}
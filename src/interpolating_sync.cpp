@@ -0,0 +1,181 @@
+#include "drive_ros_localize_odom_fusion/interpolating_sync.h"
+
+// system
+#include <cmath>
+#include <limits>
+
+InterpolatingSync::InterpolatingSync(const Stream s, const double max):
+  interpolated(s), max_interval(max)
+{
+  reset();
+}
+
+void InterpolatingSync::setCallback(const Callback& cb)
+{
+  callback = cb;
+}
+
+void InterpolatingSync::setInterpolated(const Stream s)
+{
+  interpolated = s;
+  reset();
+}
+
+void InterpolatingSync::setMaxInterval(const double max)
+{
+  max_interval = max;
+}
+
+void InterpolatingSync::reset()
+{
+  odos.clear();
+  imus.clear();
+  newest_odo = -std::numeric_limits<double>::infinity();
+  newest_imu = -std::numeric_limits<double>::infinity();
+}
+
+void InterpolatingSync::addOdo(const OdoData& odo)
+{
+  // keep the rings sorted by time
+  if(odo.stamp <= newest_odo)
+  {
+    if(ODO != interpolated) dropped_anchors++;
+    return;
+  }
+  newest_odo = odo.stamp;
+
+  if(!odos.push(odo) && ODO != interpolated)
+  {
+    dropped_anchors++;
+  }
+
+  if(ODO == interpolated) process(imus, odos);
+  else                    process(odos, imus);
+}
+
+void InterpolatingSync::addImu(const ImuData& imu)
+{
+  if(imu.stamp <= newest_imu)
+  {
+    if(IMU != interpolated) dropped_anchors++;
+    return;
+  }
+  newest_imu = imu.stamp;
+
+  if(!imus.push(imu) && IMU != interpolated)
+  {
+    dropped_anchors++;
+  }
+
+  if(ODO == interpolated) process(imus, odos);
+  else                    process(odos, imus);
+}
+
+template<class Anchor, class Sample>
+void InterpolatingSync::process(Ring<Anchor>& anchors, Ring<Sample>& samples)
+{
+  FilterSample out;
+
+  while(!anchors.empty() && !samples.empty())
+  {
+    const Anchor& a = anchors.front();
+
+    // no sample at or after the anchor yet -> wait, unless the bracket gets too wide anyway
+    if(samples.back().stamp < a.stamp)
+    {
+      if(a.stamp - samples.back().stamp > max_interval)
+      {
+        anchors.pop();
+        dropped_anchors++;
+        continue;
+      }
+      return;
+    }
+
+    // anchor older than all samples
+    if(samples.front().stamp > a.stamp)
+    {
+      anchors.pop();
+      dropped_anchors++;
+      continue;
+    }
+
+    // newest sample at or before the anchor (the next one is at or after it)
+    size_t lo = 0;
+    while(lo + 1 < samples.size() && samples.at(lo + 1).stamp <= a.stamp)
+    {
+      lo++;
+    }
+    const Sample& s_lo = samples.at(lo);
+    const Sample& s_hi = (s_lo.stamp == a.stamp) ? s_lo : samples.at(lo + 1);
+
+    const double interval = s_hi.stamp - s_lo.stamp;
+    if(interval > max_interval)
+    {
+      dropped_anchors++;
+    }
+    else
+    {
+      const double w = (interval > 0) ? (a.stamp - s_lo.stamp)/interval : 0;
+      combine(a, s_lo, s_hi, w, out);
+      if(callback)
+      {
+        callback(out);
+      }
+    }
+
+    // older samples are not needed by newer anchors
+    for(size_t i = 0; i < lo; i++)
+    {
+      samples.pop();
+    }
+    anchors.pop();
+  }
+}
+
+void InterpolatingSync::combine(const OdoData& anchor, const ImuData& lo, const ImuData& hi,
+                                const double w, FilterSample& out)
+{
+  out.stamp   = anchor.stamp;
+  out.has_odo = true;
+  out.has_imu = true;
+  out.odo     = anchor;
+
+  out.imu.stamp                 = anchor.stamp;
+  out.imu.angular_velocity_z    = lo.angular_velocity_z    + w*(hi.angular_velocity_z    - lo.angular_velocity_z);
+  out.imu.linear_acceleration_x = lo.linear_acceleration_x + w*(hi.linear_acceleration_x - lo.linear_acceleration_x);
+}
+
+void InterpolatingSync::combine(const ImuData& anchor, const OdoData& lo, const OdoData& hi,
+                                const double w, FilterSample& out)
+{
+  out.stamp   = anchor.stamp;
+  out.has_odo = true;
+  out.has_imu = true;
+  out.imu     = anchor;
+
+  // covariance of the nearer sample
+  out.odo = (w < 0.5) ? lo : hi;
+  out.odo.stamp = anchor.stamp;
+
+  out.odo.position_x        = lo.position_x        + w*(hi.position_x        - lo.position_x);
+  out.odo.position_y        = lo.position_y        + w*(hi.position_y        - lo.position_y);
+  out.odo.linear_velocity_x = lo.linear_velocity_x + w*(hi.linear_velocity_x - lo.linear_velocity_x);
+  out.odo.linear_velocity_y = lo.linear_velocity_y + w*(hi.linear_velocity_y - lo.linear_velocity_y);
+
+  // normalized lerp along the shorter arc
+  const double sign = (lo.orientation_x*hi.orientation_x + lo.orientation_y*hi.orientation_y +
+                       lo.orientation_z*hi.orientation_z + lo.orientation_w*hi.orientation_w) < 0 ? -1 : 1;
+  double qx = (1 - w)*lo.orientation_x + w*sign*hi.orientation_x;
+  double qy = (1 - w)*lo.orientation_y + w*sign*hi.orientation_y;
+  double qz = (1 - w)*lo.orientation_z + w*sign*hi.orientation_z;
+  double qw = (1 - w)*lo.orientation_w + w*sign*hi.orientation_w;
+  const double n = std::sqrt(qx*qx + qy*qy + qz*qz + qw*qw);
+  if(n > 0)
+  {
+    out.odo.orientation_x = qx/n;
+    out.odo.orientation_y = qy/n;
+    out.odo.orientation_z = qz/n;
+    out.odo.orientation_w = qw/n;
+  }
+}
@@ -0,0 +1,103 @@
+#include "drive_ros_localize_odom_fusion/latency_stats.h"
+
+// system
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+LatencyHistogram::LatencyHistogram()
+{
+  reset();
+}
+
+void LatencyHistogram::reset()
+{
+  for(size_t b = 0; b < BUCKETS; b++)
+  {
+    counts[b].store(0, std::memory_order_relaxed);
+  }
+  total.store(0, std::memory_order_relaxed);
+  maximum.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::upperBound(const size_t b)
+{
+  if(b < SUB_BUCKETS)
+    return b;
+
+  const size_t shift = b / SUB_BUCKETS - 1;
+  const uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + b % SUB_BUCKETS) << shift;
+  return lower + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+uint64_t LatencyHistogram::percentile(const double p) const
+{
+  const uint64_t n = count();
+  if(0 == n)
+    return 0;
+
+  // rank of the sample (1..n)
+  uint64_t rank = static_cast<uint64_t>(std::ceil(p * n));
+  rank = std::max<uint64_t>(1, std::min(rank, n));
+
+  uint64_t sum = 0;
+  for(size_t b = 0; b < BUCKETS; b++)
+  {
+    sum += counts[b].load(std::memory_order_relaxed);
+    if(sum >= rank)
+    {
+      return std::min(upperBound(b), max());
+    }
+  }
+
+  // samples recorded while reading
+  return max();
+}
+
+const char* LatencyStats::name(const Stage stage)
+{
+  switch(stage)
+  {
+    case PRED_DELAY: return "pred_stamp_to_callback";
+    case CORR_DELAY: return "corr_stamp_to_callback";
+    case MUTEX_WAIT: return "mutex_wait";
+    case PREDICT:    return "predict";
+    case CORRECT:    return "correct";
+    case GET_OUTPUT: return "get_output";
+    case PUBLISH:    return "publish";
+    case SEND_TF:    return "send_tf";
+    case DEBUG_LOG:  return "debug_log";
+    default:         return "unknown";
+  }
+}
+
+void LatencyStats::reset()
+{
+  for(size_t s = 0; s < STAGES; s++)
+  {
+    stages[s].reset();
+  }
+}
+
+std::string LatencyStats::report() const
+{
+  std::ostringstream ss;
+  ss << std::left << std::setw(24) << "stage [us]"
+     << std::right << std::setw(10) << "count"
+     << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+     << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+
+  ss << std::fixed << std::setprecision(1);
+  for(size_t s = 0; s < STAGES; s++)
+  {
+    const LatencyHistogram& h = stages[s];
+    ss << std::left << std::setw(24) << name(static_cast<Stage>(s))
+       << std::right << std::setw(10) << h.count()
+       << std::setw(10) << h.percentile(0.5)   * 1e-3
+       << std::setw(10) << h.percentile(0.9)   * 1e-3
+       << std::setw(10) << h.percentile(0.99)  * 1e-3
+       << std::setw(10) << h.percentile(0.999) * 1e-3
+       << std::setw(10) << h.max()             * 1e-3 << "\n";
+  }
+  return ss.str();
+}
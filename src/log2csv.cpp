@@ -0,0 +1,72 @@
+#include <iostream>
+
+#include "drive_ros_localize_odom_fusion/fusion_log.h"
+#include "drive_ros_localize_odom_fusion/trajectory_log.h"
+#include "drive_ros_localize_odom_fusion/trajectory_columns.h"
+#include "drive_ros_localize_odom_fusion/msg_conversions.h"
+#include "drive_ros_localize_odom_fusion/save_odom_in_CSV.h"
+
+/*
+ * Converts a binary trajectory log (debug_out_format:=bin or replay --out_bin)
+ * into the CSV layout of debug_out or into a columnar file:
+ *
+ *   drive_ros_localize_odom_fusion_log2csv /tmp/odom_debug.bin /tmp/odom_debug.csv
+ *   drive_ros_localize_odom_fusion_log2csv --columns /tmp/odom_debug.bin /tmp/odom_debug.col
+ *
+ */
+
+int main(int argc, char **argv)
+{
+  const bool columns = (4 == argc && std::string("--columns") == argv[1]);
+
+  if(3 != argc && !columns)
+  {
+    std::cout << "Usage: " << argv[0] << " [--columns] <log_file> <csv_file|col_file>" << std::endl;
+    return 1;
+  }
+
+  const char* in_file  = argv[argc - 2];
+  const char* out_file = argv[argc - 1];
+
+  std::vector<FilterOutput> records;
+  if(!TrajectoryLog::read(in_file, records))
+  {
+    return 2;
+  }
+
+  // columnar file
+  if(columns)
+  {
+    if(!TrajectoryColumns::write(out_file, records))
+    {
+      return 2;
+    }
+
+    std::cout << "Converted " << records.size() << " records." << std::endl;
+    return 0;
+  }
+
+  std::ofstream file_out_log;
+  SaveOdomInCSV::writeHeader(out_file, file_out_log);
+
+  // same conversion as for the published messages
+  geometry_msgs::TransformStamped tf;
+  nav_msgs::Odometry odom;
+
+  for(const FilterOutput& out : records)
+  {
+    MsgConversions::toMsg(out, tf, odom);
+    SaveOdomInCSV::writeMsg(odom, file_out_log);
+  }
+
+  // also fails if the file could not be opened
+  file_out_log.close();
+  if(file_out_log.fail())
+  {
+    FUSION_ERROR_STREAM("Writing " << out_file << " failed.");
+    return 2;
+  }
+
+  std::cout << "Converted " << records.size() << " records." << std::endl;
+  return 0;
+}
@@ -1,5 +1,5 @@
-#include "drive_ros_localize_odom_fusion/CTRA_wrapper.h"
-#include "drive_ros_localize_odom_fusion/CTRV_wrapper.h"
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/odom_fusion_node.h"
 
 // main function
 int main(int argc, char **argv)
@@ -14,30 +14,23 @@ int main(int argc, char **argv)
   ros::Duration(2.0).sleep();
 #endif
 
-  // pointer to model
-  BaseWrapper* model;
-
   // which model to use?
   std::string vehicle_model;
-  pnh.param<std::string>("vehicle_model", vehicle_model, "CTRA");
-
-  if("CTRA" == vehicle_model){
-
-    model = new CTRAWrapper(nh, pnh);
-
-  }else if("CTRV" == vehicle_model){
-
-    model = new CTRVWrapper(nh, pnh);
+  pnh.param<std::string>("vehicle_model", vehicle_model, ModelRegistry::defaultName());
 
-  }else{
-
-    ROS_ERROR_STREAM("Invalid vehicle model: " << vehicle_model);
+  BaseWrapper* model = ModelRegistry::create(vehicle_model);
+  if(NULL == model)
+  {
+    ROS_ERROR_STREAM("Invalid vehicle model: " << vehicle_model << " (" << ModelRegistry::names() << ")");
     return 1;
   }
 
 
+  // ros interface for model
+  OdomFusionNode node(nh, pnh, model);
+
   // initialize ros stuff
-  if(model->initROS())
+  if(node.initROS())
   {
     ROS_INFO("Odometry fusion node succesfully initialized");
 
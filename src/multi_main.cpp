@@ -0,0 +1,86 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/odom_fusion_node.h"
+#include "drive_ros_localize_odom_fusion/strand_callback_queue.h"
+
+// one fusion pipeline, members destroyed bottom up
+struct Vehicle
+{
+  StrandPool::StrandPtr strand;
+  std::unique_ptr<StrandCallbackQueue> queue;
+  std::unique_ptr<BaseWrapper> model;
+  std::unique_ptr<OdomFusionNode> node;
+};
+
+// main function: one fusion pipeline per entry of ~vehicles, all running on
+// one thread pool. The parameters of vehicle <name> are the node parameters
+// in ~<name>/, relative topics are resolved in the namespace <name>.
+int main(int argc, char **argv)
+{
+  // set up node
+  ros::init(argc, argv, "odom_fusion_multi");
+  ros::NodeHandle pnh("~");
+
+  std::vector<std::string> names;
+  pnh.param<std::vector<std::string> >("vehicles", names, std::vector<std::string>());
+  if(names.empty())
+  {
+    ROS_ERROR("No vehicles given (~vehicles)");
+    return 1;
+  }
+
+  // threads 0 = one per hardware thread
+  int threads;
+  pnh.param<int>("threads", threads, 0);
+  StrandPool pool(threads > 0 ? threads : 0);
+
+  std::vector<std::unique_ptr<Vehicle> > vehicles;
+  for(const std::string& name : names)
+  {
+    std::unique_ptr<Vehicle> v(new Vehicle);
+
+    // all callbacks of a vehicle go through its strand
+    v->strand = pool.createStrand();
+    v->queue.reset(new StrandCallbackQueue(v->strand));
+
+    ros::NodeHandle nh(name);
+    ros::NodeHandle vpnh(pnh, name);
+    nh.setCallbackQueue(v->queue.get());
+    vpnh.setCallbackQueue(v->queue.get());
+
+    // which model to use?
+    std::string vehicle_model;
+    vpnh.param<std::string>("vehicle_model", vehicle_model, ModelRegistry::defaultName());
+
+    v->model.reset(ModelRegistry::create(vehicle_model));
+    if(!v->model)
+    {
+      ROS_ERROR_STREAM(name << ": invalid vehicle model: " << vehicle_model << " (" << ModelRegistry::names() << ")");
+      return 1;
+    }
+
+    // ros interface for model (callbacks queue up until the pool starts)
+    v->node.reset(new OdomFusionNode(nh, vpnh, v->model.get()));
+    if(!v->node->initROS())
+    {
+      ROS_ERROR_STREAM(name << ": odometry fusion failed!");
+      return 1;
+    }
+
+    vehicles.push_back(std::move(v));
+  }
+
+  pool.start();
+  ROS_INFO_STREAM("Odometry fusion of " << vehicles.size() << " vehicles on " << pool.threads() << " threads succesfully initialized");
+
+  // the pool processes all callbacks, nothing to spin here
+  ros::waitForShutdown();
+
+  // no callback may run while the nodes are destroyed
+  pool.stop();
+  vehicles.clear();
+  return 0;
+}
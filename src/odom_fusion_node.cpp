@@ -0,0 +1,820 @@
+#include "drive_ros_localize_odom_fusion/odom_fusion_node.h"
+#include "drive_ros_localize_odom_fusion/msg_conversions.h"
+#include "drive_ros_localize_odom_fusion/save_odom_in_CSV.h"
+
+// system
+#include <iomanip>
+#include <pthread.h>
+#include <sstream>
+
+// forward filter core log messages to rosconsole
+static void logToROS(FusionLog::Level level, const std::string& msg)
+{
+  switch(level)
+  {
+    case FusionLog::Debug: ROS_DEBUG_STREAM(msg); break;
+    case FusionLog::Info:  ROS_INFO_STREAM(msg);  break;
+    case FusionLog::Warn:  ROS_WARN_STREAM(msg);  break;
+    default:               ROS_ERROR_STREAM(msg); break;
+  }
+}
+
+// copy the inputs of one filter step
+static FilterSample toSample(double stamp, const OdoData* odo, const ImuData* imu)
+{
+  FilterSample sample;
+  sample.stamp   = stamp;
+  sample.has_odo = (NULL != odo);
+  sample.has_imu = (NULL != imu);
+  if(odo) sample.odo = *odo;
+  if(imu) sample.imu = *imu;
+  return sample;
+}
+
+OdomFusionNode::OdomFusionNode(ros::NodeHandle& n, ros::NodeHandle& p, BaseWrapper* m):
+  nh(n), pnh(p), model(m), pred_nh(p), corr_nh(p)
+{
+}
+
+OdomFusionNode::~OdomFusionNode()
+{
+  // stop callback threads before the filter they feed
+  spinning = false;
+  for(std::thread& t : callback_threads)
+  {
+    t.join();
+  }
+  delete filter_thread;
+  delete latency_stats;
+}
+
+bool OdomFusionNode::initROS()
+{
+  /*
+   * #######################
+   * Parameter and Publisher
+   * #######################
+   */
+
+  // queue for subscribers and sync policy
+  int queue_size;
+
+  // file path
+  std::string debug_out_file_path, debug_out_format, odo_out_topic;
+
+  // ros parameters
+  pnh.param<std::string>("static_frame", static_frame, "");
+  pnh.param<std::string>("moving_frame", moving_frame, "");
+
+  pnh.param<std::string>("pred_odo_topic_name", pred_odo_topic, "");
+  pnh.param<std::string>("pred_imu_topic_name", pred_imu_topic, "");
+  pnh.param<std::string>("corr_odo_topic_name", corr_odo_topic, "");
+  pnh.param<std::string>("corr_imu_topic_name", corr_imu_topic, "");
+
+  pnh.param<std::string>("odo_out_topic", odo_out_topic, "/odom");
+
+  // output rates [Hz] (0 = every prediction, negative = never)
+  double odom_rate, tf_rate;
+  pnh.param<double>("odom_rate", odom_rate, 0);
+  pnh.param<double>("tf_rate", tf_rate, 0);
+  pnh.param<bool>("odom_lazy", odom_lazy, false);
+  output_scheduler.setRates(odom_rate, tf_rate);
+
+  pnh.param<int>("queue_size", queue_size, 5);
+
+  // synchronization of odometry and IMU ("approximate" or "interpolate")
+  std::string sync_policy;
+  pnh.param<std::string>("sync_policy", sync_policy, "approximate");
+  const bool interpolate = ("interpolate" == sync_policy);
+  pnh.param<std::string>("debug_out_file_path", debug_out_file_path, "/tmp/odom_debug.csv");
+  pnh.param<bool>("debug_out", debug_out_file, false);
+  pnh.param<std::string>("debug_out_format", debug_out_format, "csv");
+  debug_out_binary = ("bin" == debug_out_format);
+
+  float time_threshold_fl;
+  pnh.param<float>("time_threshold", time_threshold_fl, 0.5);
+  model->setTimeThreshold(time_threshold_fl);
+
+  // number of past steps kept to apply late samples at their true time
+  int history_size;
+  pnh.param<int>("history_size", history_size, 0);
+  model->setHistorySize(history_size);
+
+  // filter core logging (only format debug messages if they are shown)
+  std::map<std::string, ros::console::levels::Level> loggers;
+  ros::console::get_loggers(loggers);
+  FusionLog::setHandler(&logToROS);
+  FusionLog::setLevel(ros::console::levels::Debug == loggers[ROSCONSOLE_DEFAULT_NAME] ?
+                      FusionLog::Debug : FusionLog::Info);
+
+  // run the filter in its own thread, callbacks only queue the samples
+  bool use_filter_thread;
+  int filter_thread_queue_size;
+  pnh.param<bool>("filter_thread", use_filter_thread, false);
+  pnh.param<int>("filter_thread_queue_size", filter_thread_queue_size, 64);
+  if(use_filter_thread)
+  {
+    ROS_INFO_STREAM("Run filter in own thread. Queue size: " << filter_thread_queue_size);
+    filter_thread = new FilterThread(model, filter_thread_queue_size,
+                                     boost::bind(&OdomFusionNode::publishOutput, this, _1, _2),
+                                     boost::bind(&OdomFusionNode::outputsDue, this, _1));
+  }
+
+  // integrate IMU prediction samples over a window into one prediction (0 disables)
+  double imu_preintegration_window;
+  pnh.param<double>("imu_preintegration_window", imu_preintegration_window, 0);
+  imu_preintegration.setWindow(imu_preintegration_window);
+  if(imu_preintegration_window > 0)
+  {
+    ROS_INFO_STREAM("Pre-integrate IMU samples over " << imu_preintegration_window << " s.");
+  }
+
+  // odometry extrapolated from the newest state at a fixed rate (0 disables)
+  double extrapolation_rate;
+  std::string extrapolation_topic;
+  pnh.param<double>("extrapolation_rate", extrapolation_rate, 0);
+  pnh.param<double>("extrapolation_lookahead", extrapolation_lookahead, 0);
+  pnh.param<std::string>("extrapolation_topic", extrapolation_topic, "/odom_extrapolated");
+  if(extrapolation_rate > 0)
+  {
+    ROS_INFO_STREAM("Extrapolate odometry to " << extrapolation_topic << " with " << extrapolation_rate
+                    << " Hz, lookahead: " << extrapolation_lookahead);
+    model->setExtrapolation(true);
+    extrapolation_pub = nh.advertise<nav_msgs::Odometry>(extrapolation_topic, 1);
+    extrapolation_timer = nh.createTimer(ros::Rate(extrapolation_rate).expectedCycleTime(),
+                                         &OdomFusionNode::publishExtrapolation, this);
+  }
+
+  // per stage latency histograms of the hot path
+  bool use_latency_stats;
+  double latency_stats_period;
+  pnh.param<bool>("latency_stats", use_latency_stats, false);
+  pnh.param<double>("latency_stats_period", latency_stats_period, 1.0);
+  if(use_latency_stats)
+  {
+    ROS_INFO_STREAM("Latency statistics enabled. Diagnostics period: " << latency_stats_period);
+    latency_stats = new LatencyStats();
+    model->setLatencyStats(latency_stats);
+    diag_pub = nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+    latency_timer = nh.createTimer(ros::Duration(latency_stats_period), &OdomFusionNode::publishLatency, this);
+    dump_latency = pnh.advertiseService("dump_latency", &OdomFusionNode::svrDumpLatency, this);
+  }
+
+  // process prediction and correction callbacks in their own queues and threads
+  bool callback_queues;
+  int pred_threads, corr_threads;
+  std::vector<int> pred_cpus, corr_cpus;
+  pnh.param<bool>("callback_queues", callback_queues, false);
+  pnh.param<int>("pred_threads", pred_threads, 1);
+  pnh.param<int>("corr_threads", corr_threads, 1);
+  pnh.param<std::vector<int> >("pred_cpus", pred_cpus, std::vector<int>());
+  pnh.param<std::vector<int> >("corr_cpus", corr_cpus, std::vector<int>());
+  if(callback_queues && (pred_threads > 1 || corr_threads > 1))
+  {
+    // several threads per queue process samples out of order: the filter
+    // thread rings have exactly one producer and without a history a late
+    // sample is predicted with the previous delta
+    if(filter_thread || 0 == history_size)
+    {
+      ROS_WARN("pred_threads/corr_threads > 1 need history_size > 0 and no filter_thread. Using 1 thread each.");
+      pred_threads = 1;
+      corr_threads = 1;
+    }
+  }
+  if(callback_queues)
+  {
+    pred_nh.setCallbackQueue(&pred_queue);
+    corr_nh.setCallbackQueue(&corr_queue);
+  }
+
+  // output messages (frames set once)
+  nav_msgs::Odometry odom_prototype;
+  odom_prototype.header.frame_id = static_frame;
+  odom_prototype.child_frame_id  = moving_frame;
+  odom_pool.setPrototype(odom_prototype, 8);
+  extrapolation_pool.setPrototype(odom_prototype, 4);
+
+  tf2_msgs::TFMessage tf_prototype;
+  tf_prototype.transforms.resize(1);
+  tf_prototype.transforms[0].header.frame_id = static_frame;
+  tf_prototype.transforms[0].child_frame_id  = moving_frame;
+  tf_pool.setPrototype(tf_prototype, 8);
+
+  // odometry and tf publisher (same queue size as tf2_ros::TransformBroadcaster)
+  odo_pub = nh.advertise<nav_msgs::Odometry>(odo_out_topic, 0);
+  tf_pub = nh.advertise<tf2_msgs::TFMessage>("/tf", 100);
+
+  // debug file
+  if(debug_out_file && debug_out_binary){
+    ROS_INFO_STREAM("Debug to binary file: " << debug_out_file_path);
+    debug_out_file = trajectory_log.open(debug_out_file_path);
+    if(!debug_out_file)
+    {
+      ROS_ERROR_STREAM("Opening debug file failed!");
+    }
+  }else if(debug_out_file){
+    ROS_INFO_STREAM("Debug to file: " << debug_out_file_path);
+    SaveOdomInCSV::writeHeader(debug_out_file_path, file_out_log);
+  }
+
+  // init services
+  reload_proc_cov = pnh.advertiseService("reset", &OdomFusionNode::svrReset, this);
+  reload_cov = pnh.advertiseService("reload_cov", &OdomFusionNode::svrReloadCov, this);
+
+  /* ###########################
+   * PREDICTION subscriber setup
+   * ###########################
+   */
+
+  // only IMU data is available for prediction
+  if(pred_odo_topic.empty()){
+
+    ROS_INFO_STREAM("Setup single prediction subscriber for: " << pred_imu_topic);
+    pred_imu_single_sub = pred_nh.subscribe(pred_imu_topic, queue_size, &OdomFusionNode::predImuCallback, this);
+
+  // only odometry data is available for prediction
+  }else if(pred_imu_topic.empty()){
+
+    ROS_INFO_STREAM("Setup single prediction subscriber for: " << pred_odo_topic);
+    pred_odo_single_sub = pred_nh.subscribe(pred_odo_topic, queue_size, &OdomFusionNode::predOdoCallback, this);
+
+  // both odometry and IMU data are available for prediction, faster stream interpolated
+  }else if(interpolate){
+
+    ROS_INFO_STREAM("Setup interpolating prediction synchronizer for: " << pred_odo_topic << " and " << pred_imu_topic);
+    setupInterpSync(pred_interp, "pred");
+    pred_interp.setCallback(boost::bind(&OdomFusionNode::predInterpCallback, this, _1));
+    pred_odo_single_sub = pred_nh.subscribe(pred_odo_topic, queue_size, &OdomFusionNode::predInterpOdoCallback, this);
+    pred_imu_single_sub = pred_nh.subscribe(pred_imu_topic, queue_size, &OdomFusionNode::predInterpImuCallback, this);
+
+  // both odometry and IMU data are available for prediction
+  }else{
+
+    ROS_INFO_STREAM("Setup synchronized prediction subscriber for: " << pred_odo_topic << " and " << pred_imu_topic);
+    pred_odo_sub = new message_filters::Subscriber<nav_msgs::Odometry>(pred_nh, pred_odo_topic, queue_size);
+    pred_imu_sub = new message_filters::Subscriber<sensor_msgs::Imu>(pred_nh, pred_imu_topic, queue_size);
+
+    // initialize policy and register sync callback
+    pred_policy = new SyncPolicy(queue_size);
+    pred_sync = new message_filters::Synchronizer<SyncPolicy>(static_cast<SyncPolicy>(*pred_policy), *pred_odo_sub, *pred_imu_sub);
+    pred_sync->registerCallback(boost::bind(&OdomFusionNode::predSyncCallback, this, _1, _2));
+
+    // parameters can be found here: http://wiki.ros.org/message_filters/ApproximateTime
+    double age_penalty, odo_topic_rate, imu_topic_rate, max_time_between_imu_odo;
+    pnh.param<double>("pred_age_penalty", age_penalty, 5);
+    pnh.param<double>("pred_max_time_between_imu_odo", max_time_between_imu_odo, 0.01);
+    pnh.param<double>("pred_odo_topic_rate", odo_topic_rate, 100);
+    pnh.param<double>("pred_imu_topic_rate", imu_topic_rate, 100);
+
+    // the synchronizer holds its own copy of the policy
+    pred_sync->setAgePenalty(age_penalty);
+    pred_sync->setMaxIntervalDuration(ros::Duration(max_time_between_imu_odo));
+
+    // lower bound should be half of the time period (= double the rate) for each topic
+    pred_sync->setInterMessageLowerBound(0, ros::Rate(odo_topic_rate*2).expectedCycleTime());
+    pred_sync->setInterMessageLowerBound(1, ros::Rate(imu_topic_rate*2).expectedCycleTime());
+  }
+
+  /* ###########################
+   * CORRECTION subscriber setup
+   * ###########################
+   */
+
+  // only IMU data is available for correction
+  if(corr_odo_topic.empty()){
+
+    ROS_INFO_STREAM("Setup single correction subscriber for: " << corr_imu_topic);
+    corr_imu_single_sub = corr_nh.subscribe(corr_imu_topic, queue_size, &OdomFusionNode::corrImuCallback, this);
+
+  // only odometry data is available for correction
+  }else if(corr_imu_topic.empty()){
+
+    ROS_INFO_STREAM("Setup single correction subscriber for: " << corr_odo_topic);
+    corr_odo_single_sub = corr_nh.subscribe(corr_odo_topic, queue_size, &OdomFusionNode::corrOdoCallback, this);
+
+  // both odometry and IMU data are available for correction, faster stream interpolated
+  }else if(interpolate){
+
+    ROS_INFO_STREAM("Setup interpolating correction synchronizer for: " << corr_odo_topic << " and " << corr_imu_topic);
+    setupInterpSync(corr_interp, "corr");
+    corr_interp.setCallback(boost::bind(&OdomFusionNode::corrInterpCallback, this, _1));
+    corr_odo_single_sub = corr_nh.subscribe(corr_odo_topic, queue_size, &OdomFusionNode::corrInterpOdoCallback, this);
+    corr_imu_single_sub = corr_nh.subscribe(corr_imu_topic, queue_size, &OdomFusionNode::corrInterpImuCallback, this);
+
+  // both odometry and IMU data are available for correction
+  }else{
+
+    ROS_INFO_STREAM("Setup synchronized correction subscriber for: " << corr_odo_topic << " and " << corr_imu_topic);
+    corr_odo_sub = new message_filters::Subscriber<nav_msgs::Odometry>(corr_nh, corr_odo_topic, queue_size);
+    corr_imu_sub = new message_filters::Subscriber<sensor_msgs::Imu>(corr_nh, corr_imu_topic, queue_size);
+
+    // initialize policy and register sync callback
+    corr_policy = new SyncPolicy(queue_size);
+    corr_sync = new message_filters::Synchronizer<SyncPolicy>(static_cast<SyncPolicy>(*corr_policy), *corr_odo_sub, *corr_imu_sub);
+    corr_sync->registerCallback(boost::bind(&OdomFusionNode::corrSyncCallback, this, _1, _2));
+
+    // parameters can be found here: http://wiki.ros.org/message_filters/ApproximateTime
+    double age_penalty, odo_topic_rate, imu_topic_rate, max_time_between_imu_odo;
+    pnh.param<double>("corr_age_penalty", age_penalty, 5);
+    pnh.param<double>("corr_max_time_between_imu_odo", max_time_between_imu_odo, 0.1);
+    pnh.param<double>("corr_odo_topic_rate", odo_topic_rate, 100);
+    pnh.param<double>("corr_imu_topic_rate", imu_topic_rate, 100);
+
+    // the synchronizer holds its own copy of the policy
+    corr_sync->setAgePenalty(age_penalty);
+    corr_sync->setMaxIntervalDuration(ros::Duration(max_time_between_imu_odo));
+
+    // lower bound should be half of the time period (= double the rate) for each topic
+    corr_sync->setInterMessageLowerBound(0, ros::Rate(odo_topic_rate*2).expectedCycleTime());
+    corr_sync->setInterMessageLowerBound(1, ros::Rate(imu_topic_rate*2).expectedCycleTime());
+  }
+
+  // load covariances once and reset filter
+  if(!reloadKalmanCov() || !reset())
+  {
+    return false;
+  }
+
+  if(filter_thread)
+  {
+    filter_thread->start();
+  }
+
+  if(callback_queues)
+  {
+    startCallbackThreads(pred_threads, pred_cpus, corr_threads, corr_cpus);
+  }
+  return true;
+
+}
+
+void OdomFusionNode::startCallbackThreads(const int pred_threads, const std::vector<int>& pred_cpus,
+                                          const int corr_threads, const std::vector<int>& corr_cpus)
+{
+  ROS_INFO_STREAM("Separate callback queues. Prediction threads: " << pred_threads
+                  << " correction threads: " << corr_threads);
+
+  spinning = true;
+
+  for(int i = 0; i < pred_threads + corr_threads; i++)
+  {
+    const bool pred = i < pred_threads;
+    const std::vector<int>& cpus = pred ? pred_cpus : corr_cpus;
+
+    callback_threads.push_back(std::thread(&OdomFusionNode::spinQueue, this,
+                                           pred ? &pred_queue : &corr_queue));
+    pthread_t handle = callback_threads.back().native_handle();
+    pthread_setname_np(handle, pred ? "odom_fusion_pred" : "odom_fusion_corr");
+
+    // pin thread to the given cpus
+    if(!cpus.empty())
+    {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for(int cpu : cpus)
+      {
+        CPU_SET(cpu, &set);
+      }
+
+      if(0 != pthread_setaffinity_np(handle, sizeof(set), &set))
+      {
+        ROS_WARN_STREAM("Setting cpu affinity of " << (pred ? "prediction" : "correction")
+                        << " thread failed.");
+      }
+    }
+  }
+}
+
+void OdomFusionNode::spinQueue(ros::CallbackQueue* queue)
+{
+  // the timeout only bounds the reaction to a shutdown
+  while(spinning && nh.ok())
+  {
+    queue->callAvailable(ros::WallDuration(0.1));
+  }
+}
+
+bool OdomFusionNode::loadKalmanCov(KalmanCov& cov)
+{
+  bool ret = true;
+
+  ret &= pnh.getParam("kalman_cov/filter_init_var_x",     cov.filter_init_var_x);
+  ret &= pnh.getParam("kalman_cov/filter_init_var_y",     cov.filter_init_var_y);
+  ret &= pnh.getParam("kalman_cov/filter_init_var_theta", cov.filter_init_var_theta);
+
+  ret &= pnh.getParam("kalman_cov/sys_var_x",     cov.sys_var_x);
+  ret &= pnh.getParam("kalman_cov/sys_var_y",     cov.sys_var_y);
+  ret &= pnh.getParam("kalman_cov/sys_var_theta", cov.sys_var_theta);
+
+  if(!ret)
+  {
+    ROS_ERROR("Loading kalman_cov parameters failed!");
+  }
+
+  return ret;
+}
+
+bool OdomFusionNode::reloadKalmanCov()
+{
+  // parameter server (network) access only here, never on the filter path
+  KalmanCov cov;
+  if(!loadKalmanCov(cov))
+  {
+    return false;
+  }
+
+  // validated and swapped atomically
+  return model->setKalmanCov(cov);
+}
+
+bool OdomFusionNode::reset()
+{
+  // pending IMU samples belong to the old filter
+  prediction_mutex.lock();
+  imu_preintegration.reset();
+  prediction_mutex.unlock();
+
+  // the filter thread resets the model before its next sample
+  if(filter_thread)
+  {
+    filter_thread->requestReset();
+    return true;
+  }
+
+  // reset filter
+  return model->reset();
+}
+
+// reload covariances and reset filter
+bool OdomFusionNode::svrReset(std_srvs::Trigger::Request  &req,
+                              std_srvs::Trigger::Response &res)
+{
+  res.message = "Reset Kalman Filter.";
+  return res.success = reloadKalmanCov() && reset();
+}
+
+// reload covariances without reset (process noise applies with the next prediction)
+bool OdomFusionNode::svrReloadCov(std_srvs::Trigger::Request  &req,
+                                  std_srvs::Trigger::Response &res)
+{
+  res.success = reloadKalmanCov();
+  res.message = res.success ? "Reloaded kalman_cov." : "Reloading kalman_cov failed, keeping the previous values.";
+  return true;
+}
+
+// latency percentiles since start
+bool OdomFusionNode::svrDumpLatency(std_srvs::Trigger::Request  &req,
+                                    std_srvs::Trigger::Response &res)
+{
+  res.message = latency_stats->report();
+  ROS_INFO_STREAM("Latency statistics:\n" << res.message);
+  return res.success = true;
+}
+
+void OdomFusionNode::publishLatency(const ros::TimerEvent&)
+{
+  diagnostic_msgs::DiagnosticArray array;
+  array.header.stamp = ros::Time::now();
+
+  diagnostic_msgs::DiagnosticStatus status;
+  status.level = diagnostic_msgs::DiagnosticStatus::OK;
+  status.name = ros::this_node::getName() + ": latency";
+  status.hardware_id = moving_frame;
+  status.message = "p50/p99/max [us] since start";
+
+  for(int s = 0; s < LatencyStats::STAGES; s++)
+  {
+    const LatencyStats::Stage stage = static_cast<LatencyStats::Stage>(s);
+    const LatencyHistogram& h = latency_stats->stage(stage);
+
+    std::ostringstream value;
+    value << std::fixed << std::setprecision(1)
+          << h.percentile(0.5) * 1e-3 << " / "
+          << h.percentile(0.99) * 1e-3 << " / "
+          << h.max() * 1e-3 << " (n = " << h.count() << ")";
+
+    diagnostic_msgs::KeyValue kv;
+    kv.key = LatencyStats::name(stage);
+    kv.value = value.str();
+    status.values.push_back(kv);
+  }
+
+  array.status.push_back(status);
+  diag_pub.publish(array);
+}
+
+void OdomFusionNode::publishExtrapolation(const ros::TimerEvent& event)
+{
+  // the expected timer time keeps the output stamps on a fixed grid
+  FilterOutput out;
+  if(!model->extrapolate(event.current_expected.toSec() + extrapolation_lookahead, out))
+  {
+    ROS_WARN_THROTTLE(1, "No recent filter state to extrapolate.");
+    return;
+  }
+
+  nav_msgs::OdometryPtr odom = extrapolation_pool.get();
+  MsgConversions::toMsg(out, *odom);
+
+  extrapolation_pub.publish(odom);
+}
+
+// time from the message stamp to the callback [ns]
+static uint64_t callbackDelay(double stamp)
+{
+  const double delay = ros::Time::now().toSec() - stamp;
+  return delay > 0 ? static_cast<uint64_t>(delay*1e9) : 0;
+}
+
+void OdomFusionNode::predOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo)
+{
+  OdoData odo;
+  MsgConversions::fromMsg(*msg_odo, odo);
+
+  // predict and output messages
+  processPredictionData(odo.stamp, &odo, NULL);
+}
+
+void OdomFusionNode::predImuCallback(const sensor_msgs::ImuConstPtr &msg_imu)
+{
+  ImuData imu;
+  MsgConversions::fromMsg(*msg_imu, imu);
+
+  // predict and output messages
+  processPredictionData(imu.stamp, NULL, &imu);
+}
+
+void OdomFusionNode::predSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,
+                                      const sensor_msgs::ImuConstPtr &msg_imu)
+{
+  OdoData odo;
+  ImuData imu;
+  MsgConversions::fromMsg(*msg_odo, odo);
+  MsgConversions::fromMsg(*msg_imu, imu);
+
+  // predict and output messages
+  processPredictionData((imu.stamp + odo.stamp)/2.0, &odo, &imu);
+}
+
+void OdomFusionNode::processPredictionData(double current_timestamp,
+                                           const OdoData* odo,
+                                           const ImuData* imu)
+{
+  if(latency_stats)
+  {
+    latency_stats->record(LatencyStats::PRED_DELAY, callbackDelay(current_timestamp));
+  }
+
+  // one thread at a time on the prediction path (see flushPreintegration)
+  std::lock_guard<std::mutex> guard(prediction_mutex);
+
+  // collect IMU samples until the window is full
+  if(imu && imu_preintegration.getWindow() > 0)
+  {
+    FilterSample sample;
+    const bool due = imu_preintegration.add(toSample(current_timestamp, odo, imu), sample);
+
+    if(due)
+    {
+      runPrediction(sample.stamp, sample.has_odo ? &sample.odo : NULL, &sample.imu);
+    }
+    return;
+  }
+
+  runPrediction(current_timestamp, odo, imu);
+}
+
+void OdomFusionNode::flushPreintegration()
+{
+  if(0 == imu_preintegration.getWindow())
+    return;
+
+  // called from the correction callback: the prediction mutex keeps the
+  // filter thread ring, the output schedule and the logs single producer
+  std::lock_guard<std::mutex> guard(prediction_mutex);
+
+  FilterSample sample;
+  const bool pending = imu_preintegration.flush(sample);
+
+  if(pending)
+  {
+    runPrediction(sample.stamp, sample.has_odo ? &sample.odo : NULL, &sample.imu);
+  }
+}
+
+void OdomFusionNode::runPrediction(double current_timestamp,
+                                   const OdoData* odo,
+                                   const ImuData* imu)
+{
+  // hand over to the filter thread
+  if(filter_thread)
+  {
+    if(!filter_thread->pushPrediction(toSample(current_timestamp, odo, imu)))
+    {
+      ROS_WARN_THROTTLE(1, "Prediction queue full, dropping sample.");
+    }
+    return;
+  }
+
+  // do the prediction (output only if something is due)
+  const int outputs = outputsDue(current_timestamp);
+  FilterOutput out;
+  if(!model->processPredictionData(current_timestamp, odo, imu, out, 0 != outputs) ||
+     0 == outputs)
+  {
+    return;
+  }
+
+  publishOutput(out, outputs);
+}
+
+void OdomFusionNode::processCorrectionData(double current_timestamp,
+                                           const OdoData* odo,
+                                           const ImuData* imu)
+{
+  if(latency_stats)
+  {
+    latency_stats->record(LatencyStats::CORR_DELAY, callbackDelay(current_timestamp));
+  }
+
+  // the correction applies to the state including all IMU samples so far
+  flushPreintegration();
+
+  // hand over to the filter thread
+  if(filter_thread)
+  {
+    if(!filter_thread->pushCorrection(toSample(current_timestamp, odo, imu)))
+    {
+      ROS_WARN_THROTTLE(1, "Correction queue full, dropping sample.");
+    }
+    return;
+  }
+
+  // correct
+  model->processCorrectionData(current_timestamp, odo, imu);
+}
+
+int OdomFusionNode::outputsDue(double stamp)
+{
+  output_mutex.lock();
+  int outputs = output_scheduler.due(stamp);
+  output_mutex.unlock();
+
+  // nobody listens
+  if(odom_lazy && 0 == odo_pub.getNumSubscribers())
+  {
+    outputs &= ~OutputScheduler::ODOM;
+  }
+
+  // the debug file gets every prediction
+  if(debug_out_file)
+  {
+    outputs |= OutputScheduler::LOG;
+  }
+  return outputs;
+}
+
+void OdomFusionNode::publishOutput(const FilterOutput& out, int outputs)
+{
+  uint64_t t = latency_stats ? LatencyStats::now() : 0;
+
+  // binary debug log (only queues the output, written by the log thread)
+  if(debug_out_file && debug_out_binary)
+  {
+    trajectory_log.log(out);
+    if(latency_stats) t = latency_stats->lap(LatencyStats::DEBUG_LOG, t);
+  }
+
+  // output messages from the pools as shared pointers, so intra-process
+  // subscribers of a nodelet manager get them without serialization
+  const bool csv = debug_out_file && !debug_out_binary;
+  if((outputs & OutputScheduler::ODOM) || csv)
+  {
+    nav_msgs::OdometryPtr odom = odom_pool.get();
+    MsgConversions::toMsg(out, *odom);
+
+    // debug to file (message must not be touched after publishing), timed
+    // alone: the message fill counts as publishing
+    if(csv)
+    {
+      const uint64_t t_log = latency_stats ? LatencyStats::now() : 0;
+      SaveOdomInCSV::writeMsg(*odom, file_out_log);
+      if(latency_stats) t += latency_stats->lap(LatencyStats::DEBUG_LOG, t_log) - t_log;
+    }
+
+    if(outputs & OutputScheduler::ODOM)
+    {
+      odo_pub.publish(odom);
+      if(latency_stats) t = latency_stats->lap(LatencyStats::PUBLISH, t);
+    }
+    else if(latency_stats)
+    {
+      // message only filled for the debug file
+      t = LatencyStats::now();
+    }
+  }
+
+  if(outputs & OutputScheduler::TF)
+  {
+    tf2_msgs::TFMessagePtr tf = tf_pool.get();
+    MsgConversions::toMsg(out, tf->transforms[0]);
+
+    tf_pub.publish(tf);
+    if(latency_stats) latency_stats->lap(LatencyStats::SEND_TF, t);
+  }
+}
+
+
+void OdomFusionNode::corrOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo)
+{
+  OdoData odo;
+  MsgConversions::fromMsg(*msg_odo, odo);
+
+  // correct
+  processCorrectionData(odo.stamp, &odo, NULL);
+}
+
+void OdomFusionNode::corrImuCallback(const sensor_msgs::ImuConstPtr &msg_imu)
+{
+  ImuData imu;
+  MsgConversions::fromMsg(*msg_imu, imu);
+
+  // correct
+  processCorrectionData(imu.stamp, NULL, &imu);
+}
+
+void OdomFusionNode::corrSyncCallback(const nav_msgs::OdometryConstPtr &msg_odo,
+                                      const sensor_msgs::ImuConstPtr &msg_imu)
+{
+  OdoData odo;
+  ImuData imu;
+  MsgConversions::fromMsg(*msg_odo, odo);
+  MsgConversions::fromMsg(*msg_imu, imu);
+
+  // correct
+  processCorrectionData((imu.stamp + odo.stamp)/2.0, &odo, &imu);
+}
+
+void OdomFusionNode::setupInterpSync(InterpolatingSync& sync, const std::string& prefix)
+{
+  // the faster stream is interpolated to the stamps of the other one
+  std::string interpolated;
+  double max_interval;
+  pnh.param<std::string>(prefix + "_sync_interpolate", interpolated, "imu");
+  pnh.param<double>(prefix + "_sync_max_interval", max_interval, 0.1);
+
+  sync.setInterpolated("odo" == interpolated ? InterpolatingSync::ODO : InterpolatingSync::IMU);
+  sync.setMaxInterval(max_interval);
+}
+
+void OdomFusionNode::predInterpOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo)
+{
+  OdoData odo;
+  MsgConversions::fromMsg(*msg_odo, odo);
+
+  // predicts with every synchronized sample
+  std::lock_guard<std::mutex> guard(pred_interp_mutex);
+  pred_interp.addOdo(odo);
+}
+
+void OdomFusionNode::predInterpImuCallback(const sensor_msgs::ImuConstPtr &msg_imu)
+{
+  ImuData imu;
+  MsgConversions::fromMsg(*msg_imu, imu);
+
+  // predicts with every synchronized sample
+  std::lock_guard<std::mutex> guard(pred_interp_mutex);
+  pred_interp.addImu(imu);
+}
+
+void OdomFusionNode::corrInterpOdoCallback(const nav_msgs::OdometryConstPtr &msg_odo)
+{
+  OdoData odo;
+  MsgConversions::fromMsg(*msg_odo, odo);
+
+  // corrects with every synchronized sample
+  std::lock_guard<std::mutex> guard(corr_interp_mutex);
+  corr_interp.addOdo(odo);
+}
+
+void OdomFusionNode::corrInterpImuCallback(const sensor_msgs::ImuConstPtr &msg_imu)
+{
+  ImuData imu;
+  MsgConversions::fromMsg(*msg_imu, imu);
+
+  // corrects with every synchronized sample
+  std::lock_guard<std::mutex> guard(corr_interp_mutex);
+  corr_interp.addImu(imu);
+}
+
+void OdomFusionNode::predInterpCallback(const FilterSample& sample)
+{
+  // predict and output messages
+  processPredictionData(sample.stamp, &sample.odo, &sample.imu);
+}
+
+void OdomFusionNode::corrInterpCallback(const FilterSample& sample)
+{
+  // correct
+  processCorrectionData(sample.stamp, &sample.odo, &sample.imu);
+}
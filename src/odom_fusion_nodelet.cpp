@@ -0,0 +1,61 @@
+#include <memory>
+
+// ros
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+// filter
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/odom_fusion_node.h"
+
+/*
+ * Nodelet version of the odometry fusion node
+ *
+ * Same parameters, topics and services as the node. Loaded into the nodelet
+ * manager of the IMU and odometry drivers, messages are passed as shared
+ * pointers without serialization.
+ *
+ */
+
+namespace drive_ros_localize_odom_fusion {
+
+class OdomFusionNodelet : public nodelet::Nodelet
+{
+private:
+
+  void onInit()
+  {
+    ros::NodeHandle& nh  = getNodeHandle();
+    ros::NodeHandle& pnh = getPrivateNodeHandle();
+
+    // which model to use?
+    std::string vehicle_model;
+    pnh.param<std::string>("vehicle_model", vehicle_model, ModelRegistry::defaultName());
+
+    model.reset(ModelRegistry::create(vehicle_model));
+    if(!model)
+    {
+      NODELET_ERROR_STREAM("Invalid vehicle model: " << vehicle_model << " (" << ModelRegistry::names() << ")");
+      return;
+    }
+
+    // ros interface for model
+    node.reset(new OdomFusionNode(nh, pnh, model.get()));
+
+    if(node->initROS())
+    {
+      NODELET_INFO("Odometry fusion nodelet succesfully initialized");
+    }else{
+      NODELET_ERROR("Odometry fusion nodelet failed!");
+    }
+  }
+
+  // the node uses the model, so it has to be destroyed first
+  std::unique_ptr<BaseWrapper> model;
+  std::unique_ptr<OdomFusionNode> node;
+
+};
+
+} // namespace drive_ros_localize_odom_fusion
+
+PLUGINLIB_EXPORT_CLASS(drive_ros_localize_odom_fusion::OdomFusionNodelet, nodelet::Nodelet)
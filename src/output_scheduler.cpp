@@ -0,0 +1,52 @@
+#include "drive_ros_localize_odom_fusion/output_scheduler.h"
+
+void OutputScheduler::Channel::setRate(const double rate)
+{
+  enabled = (rate >= 0);
+  period  = (rate > 0) ? 1.0/rate : 0;
+  next    = 0;
+}
+
+bool OutputScheduler::Channel::due(const double stamp)
+{
+  if(!enabled)
+    return false;
+
+  if(0 == period)
+    return true;
+
+  // jump back in time -> restart the schedule
+  if(next - stamp > 2*period)
+  {
+    next = 0;
+  }
+
+  // accept samples slightly early, so the prediction rate jitter does not
+  // skip a whole prediction period
+  if(0 != next && stamp < next - 0.1*period)
+    return false;
+
+  // keep the phase, resync after a gap
+  next = (0 != next && stamp < next + period) ? next + period : stamp + period;
+  return true;
+}
+
+void OutputScheduler::setRates(const double odom_rate, const double tf_rate)
+{
+  odom.setRate(odom_rate);
+  tf.setRate(tf_rate);
+}
+
+int OutputScheduler::due(const double stamp)
+{
+  int outputs = NONE;
+  if(odom.due(stamp)) outputs |= ODOM;
+  if(tf.due(stamp))   outputs |= TF;
+  return outputs;
+}
+
+void OutputScheduler::reset()
+{
+  odom.next = 0;
+  tf.next   = 0;
+}
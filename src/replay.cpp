@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/replay_events.h"
+#include "drive_ros_localize_odom_fusion/replay_args.h"
+#include "drive_ros_localize_odom_fusion/replay_synthetic.h"
+#include "drive_ros_localize_odom_fusion/rts_smoother.h"
+#include "drive_ros_localize_odom_fusion/msg_conversions.h"
+#include "drive_ros_localize_odom_fusion/save_odom_in_CSV.h"
+#include "drive_ros_localize_odom_fusion/trajectory_log.h"
+#include "drive_ros_localize_odom_fusion/trajectory_columns.h"
+
+/*
+ * Offline replay tool
+ *
+ * Runs the fusion filter over a recorded bag as fast as possible without a
+ * ROS master. Arguments use the same names as the node parameters, e.g.:
+ *
+ *   drive_ros_localize_odom_fusion_replay --bag circle.bag
+ *       --config config/CTRA_cc2017_car.yaml --vehicle_model CTRA
+ *       --pred_imu_topic_name /imu --pred_odo_topic_name /odom_wheel
+ *       --corr_odo_topic_name /odom_wheel --out /tmp/odom.csv
+ *
+ * With --smooth 1 the outputs are the RTS smoothed states (rts_smoother.h)
+ * of all predictions instead of the forward filter outputs.
+ *
+ * Instead of a bag a deterministic synthetic sequence can be replayed
+ * (--synthetic, see replay_synthetic.h) and the output compared with a
+ * golden trajectory (--golden, exit code 5 if it differs). The regression
+ * mode runs every model on every synthetic sequence against the golden
+ * trajectories in a directory and reports samples/s per model:
+ *
+ *   drive_ros_localize_odom_fusion_replay --regression regression/golden
+ *
+ */
+
+using namespace Replay;
+
+// synthetic sequence names for the help
+static std::string syntheticList()
+{
+  std::string list;
+  for(const std::string& name : syntheticNames())
+  {
+    list += (list.empty() ? "" : "|") + name;
+  }
+  return list;
+}
+
+// print help and exit
+static int help()
+{
+  std::cout << "Use the following arguments:" << std::endl
+            << "  --bag <bagfile>                 (required, or --synthetic)" << std::endl
+            << "  --synthetic <" << syntheticList() << ">" << std::endl
+            << "  --config <vehicle_config>       (required)" << std::endl
+            << "  --vehicle_model <" << ModelRegistry::names() << ">     (default: " << ModelRegistry::defaultName() << ")" << std::endl
+            << "  --out <csv_file>                (default: no output)" << std::endl
+            << "  --out_bin <log_file>            (binary log, see log2csv, default: no output)" << std::endl
+            << "  --out_columns <col_file>        (columnar file, see trajectory_columns.h, default: no output)" << std::endl
+            << "  --pred_odo_topic_name <topic>" << std::endl
+            << "  --pred_imu_topic_name <topic>" << std::endl
+            << "  --corr_odo_topic_name <topic>" << std::endl
+            << "  --corr_imu_topic_name <topic>" << std::endl
+            << "  --time_threshold <sec>          (default: 0.5)" << std::endl
+            << "  --history_size <n>              (default: 0, no late sample handling)" << std::endl
+            << "  --smooth <0|1>                  (RTS smoothed output, default: 0)" << std::endl
+            << "  --smooth_chunk <steps>          (smooth in parallel chunks, default: 0 = one pass)" << std::endl
+            << "  --smooth_overlap <steps>        (overlap of the chunks, default: smooth_chunk/2)" << std::endl
+            << "  --smooth_threads <n>            (default: 0 = one per hardware thread)" << std::endl
+            << "  --queue_size <n>                (default: 5)" << std::endl
+            << "  --[pred|corr]_age_penalty, --[pred|corr]_max_time_between_imu_odo," << std::endl
+            << "  --[pred|corr]_odo_topic_rate, --[pred|corr]_imu_topic_rate" << std::endl
+            << "  --golden <col_file>             (compare the output, see tolerances)" << std::endl
+            << std::endl
+            << "Regression of all models on all synthetic sequences:" << std::endl
+            << "  --regression <golden_dir>       (<model>_<sequence>.col)" << std::endl
+            << "  --update_golden <0|1>           (write the golden trajectories, default: 0)" << std::endl
+            << "  --repeat <n>                    (runs for the throughput, default: 10)" << std::endl
+            << std::endl
+            << "Tolerances (--golden and --regression):" << std::endl
+            << "  --tolerance_position <m>        (default: 1e-3)" << std::endl
+            << "  --tolerance_theta <rad>         (default: 1e-4)" << std::endl
+            << "  --tolerance_covariance <val>    (default: 1e-6)" << std::endl;
+  return 1;
+}
+
+// compare with the golden tolerances, print and return the result
+static bool checkGolden(const Args& args, const std::vector<FilterOutput>& trajectory,
+                        const std::string& file, std::string& result)
+{
+  TrajectoryColumns golden;
+  if(!golden.open(file))
+  {
+    result = "no golden trajectory";
+    return false;
+  }
+
+  GoldenDiff diff;
+  compareGolden(trajectory, golden, diff);
+
+  GoldenTolerance tolerance;
+  tolerance.position   = param<double>(args, "tolerance_position", tolerance.position);
+  tolerance.theta      = param<double>(args, "tolerance_theta", tolerance.theta);
+  tolerance.covariance = param<double>(args, "tolerance_covariance", tolerance.covariance);
+  const bool ok = withinTolerance(diff, tolerance);
+
+  std::ostringstream ss;
+  ss << (diff.rows_match ? "" : "rows differ ")
+     << "position " << diff.position << " theta " << diff.theta << " covariance " << diff.covariance;
+  result = ss.str();
+  return ok;
+}
+
+// REGRESSION: all models on all synthetic sequences (see regressionModel)
+static int regression(const Args& args)
+{
+  const std::string dir = param<std::string>(args, "regression", "");
+  const bool update = param<int>(args, "update_golden", 0);
+  const int repeat = std::max(1, param<int>(args, "repeat", 10));
+
+  // expected resets (time_jump) are not reported
+  FusionLog::setLevel(FusionLog::Off);
+
+  std::vector<std::string> models;
+  std::istringstream names(ModelRegistry::names());
+  for(std::string name; std::getline(names, name, '|'); )
+  {
+    models.push_back(name);
+  }
+
+  bool ok = true;
+  std::vector<Event> events;
+  std::vector<FilterOutput> trajectory;
+
+  for(const std::string& model_name : models)
+  {
+    size_t samples = 0;
+    double seconds = 0;
+
+    for(const std::string& sequence : syntheticNames())
+    {
+      syntheticEvents(sequence, events);
+      trajectory.reserve(events.size());
+
+      // the output of every run is the same, the last one is compared
+      for(int r = 0; r < repeat; r++)
+      {
+        std::unique_ptr<BaseWrapper> model = regressionModel(model_name);
+        trajectory.clear();
+
+        const auto t_start = std::chrono::steady_clock::now();
+        Replay::run(*model, events, [&](const FilterOutput& out){ trajectory.push_back(out); });
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        samples += events.size();
+      }
+
+      const std::string file = dir + "/" + model_name + "_" + sequence + ".col";
+      std::string result;
+      bool passed = true;
+      if(update)
+      {
+        passed = TrajectoryColumns::write(file, trajectory);
+        result = passed ? "written" : "write failed";
+      }
+      else
+      {
+        passed = checkGolden(args, trajectory, file, result);
+      }
+      ok &= passed;
+
+      std::printf("%-5s %-12s %6zu outputs  %s  %s\n", model_name.c_str(), sequence.c_str(),
+                  trajectory.size(), passed ? "PASS" : "FAIL", result.c_str());
+    }
+
+    std::printf("%-5s %.3g samples/s\n", model_name.c_str(), samples/seconds);
+  }
+
+  return ok ? 0 : 5;
+}
+
+int main(int argc, char **argv)
+{
+  // parse "--key value" arguments
+  Args args;
+  if(!parseArgs(argc, argv, args))
+  {
+    return help();
+  }
+
+  if(args.count("regression"))
+  {
+    return regression(args);
+  }
+
+  if((!args.count("bag") && !args.count("synthetic")) || !args.count("config"))
+  {
+    return help();
+  }
+
+  // message filters use ros::Time::now() as receipt time
+  ros::Time::init();
+
+  // which model to use?
+  std::string vehicle_model = param<std::string>(args, "vehicle_model", ModelRegistry::defaultName());
+  std::unique_ptr<BaseWrapper> model(ModelRegistry::create(vehicle_model));
+  if(!model)
+  {
+    ROS_ERROR_STREAM("Invalid vehicle model: " << vehicle_model);
+    return 1;
+  }
+
+  // filter parameters
+  KalmanCov cov;
+  if(!loadKalmanCov(args["config"], cov) || !model->setKalmanCov(cov))
+  {
+    return 2;
+  }
+  model->setTimeThreshold(param<double>(args, "time_threshold", 0.5));
+  model->setHistorySize(param<int>(args, "history_size", 0));
+
+  // record the forward pass for the smoother (needs the steps in order)
+  const bool smooth = param<int>(args, "smooth", 0);
+  RtsSmoother smoother;
+  if(smooth)
+  {
+    if(param<int>(args, "history_size", 0) > 0)
+    {
+      ROS_WARN("Smoothing records the steps in processing order, history_size is ignored.");
+      model->setHistorySize(0);
+    }
+    model->setSmoother(&smoother);
+  }
+
+  // topics and synchronizer parameters
+  Replay::Config config;
+  loadConfig(args, config);
+
+  const bool synthetic = args.count("synthetic");
+  if(!synthetic && config.pred_odo_topic.empty() && config.pred_imu_topic.empty())
+  {
+    ROS_ERROR("No prediction topic provided.");
+    return help();
+  }
+
+  // decode bag or generate the synthetic sequence
+  auto t_start = std::chrono::steady_clock::now();
+
+  std::vector<Replay::Event> events;
+  if(synthetic)
+  {
+    if(!syntheticEvents(args["synthetic"], events))
+    {
+      ROS_ERROR_STREAM("Invalid synthetic sequence: " << args["synthetic"] << " (" << syntheticList() << ")");
+      return 3;
+    }
+  }
+  else if(!Replay::loadEvents(args["bag"], config, events))
+  {
+    return 3;
+  }
+  if(smooth)
+  {
+    smoother.reserve(events.size());
+  }
+
+  auto t_loaded = std::chrono::steady_clock::now();
+
+  // output file
+  const bool out_file = args.count("out");
+  std::ofstream file_out_log;
+
+  if(out_file){
+    SaveOdomInCSV::writeHeader(args["out"], file_out_log);
+  }
+
+  // binary output file (nothing is dropped offline)
+  const bool out_bin = args.count("out_bin");
+  TrajectoryLog trajectory_log;
+
+  if(out_bin && !trajectory_log.open(args["out_bin"], 4096, true)){
+    return 2;
+  }
+
+  // columnar output file (written at the end) and golden comparison
+  const bool out_columns = args.count("out_columns") || args.count("golden");
+  std::vector<FilterOutput> trajectory;
+
+  // run filter
+  if(!model->reset())
+  {
+    ROS_ERROR("Filter initialization failed!");
+    return 4;
+  }
+
+  geometry_msgs::TransformStamped tf;
+  nav_msgs::Odometry odom;
+
+  auto write = [&](const FilterOutput& out)
+  {
+    if(out_file){
+      MsgConversions::toMsg(out, tf, odom);
+      SaveOdomInCSV::writeMsg(odom, file_out_log);
+    }
+    if(out_bin){
+      trajectory_log.log(out);
+    }
+    if(out_columns){
+      trajectory.push_back(out);
+    }
+  };
+
+  size_t predictions = Replay::run(*model, events,
+    [&](const FilterOutput& out)
+    {
+      if(!smooth){
+        write(out);
+      }
+    });
+
+  // backward pass and output of the smoothed states
+  if(smooth)
+  {
+    const size_t chunk = param<size_t>(args, "smooth_chunk", 0);
+    std::vector<FilterOutput> smoothed;
+    smoother.smooth(smoothed, chunk, param<size_t>(args, "smooth_overlap", chunk/2),
+                    param<size_t>(args, "smooth_threads", 0));
+    for(const FilterOutput& out : smoothed)
+    {
+      write(out);
+    }
+  }
+
+  trajectory_log.close();
+
+  auto t_done = std::chrono::steady_clock::now();
+
+  if(args.count("out_columns") && !TrajectoryColumns::write(args["out_columns"], trajectory)){
+    return 2;
+  }
+
+  const double filter_time = std::chrono::duration<double>(t_done - t_loaded).count();
+  std::cout << "Replayed " << events.size() << " filter steps (" << predictions << " outputs)"
+            << " load: " << std::chrono::duration<double>(t_loaded - t_start).count() << "s"
+            << " filter: " << filter_time << "s"
+            << " (" << events.size()/filter_time << " samples/s)"
+            << std::endl;
+
+  // compare with the golden trajectory
+  if(args.count("golden"))
+  {
+    std::string result;
+    const bool passed = checkGolden(args, trajectory, args["golden"], result);
+    std::cout << "Golden " << args["golden"] << ": " << (passed ? "PASS" : "FAIL") << " (" << result << ")" << std::endl;
+    if(!passed)
+      return 5;
+  }
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+#include "drive_ros_localize_odom_fusion/replay_events.h"
+
+// ros
+#include <ros/console.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <message_filters/synchronizer.h>
+#include <message_filters/sync_policies/approximate_time.h>
+#include <boost/bind.hpp>
+
+// ros messages
+#include <sensor_msgs/Imu.h>
+#include <nav_msgs/Odometry.h>
+
+#include "drive_ros_localize_odom_fusion/msg_conversions.h"
+
+namespace Replay {
+
+typedef message_filters::sync_policies::ApproximateTime<nav_msgs::Odometry,
+                                                        sensor_msgs::Imu> SyncPolicy;
+
+// bag topics are always absolute, parameters might not be
+static std::string absTopic(const std::string& topic)
+{
+  if(topic.empty() || '/' == topic[0])
+    return topic;
+
+  return "/" + topic;
+}
+
+// setup synchronizer the same way the node does
+static void setupPolicy(SyncPolicy& policy, double age_penalty, double max_time_between_imu_odo,
+                        double odo_topic_rate, double imu_topic_rate)
+{
+  policy.setAgePenalty(age_penalty);
+  policy.setMaxIntervalDuration(ros::Duration(max_time_between_imu_odo));
+
+  // lower bound should be half of the time period (= double the rate) for each topic
+  policy.setInterMessageLowerBound(0, ros::Rate(odo_topic_rate*2).expectedCycleTime());
+  policy.setInterMessageLowerBound(1, ros::Rate(imu_topic_rate*2).expectedCycleTime());
+}
+
+// add event with the timestamp the node would use
+static void addEvent(std::vector<Event>& events, Event::Type type,
+                     const nav_msgs::OdometryConstPtr& odo,
+                     const sensor_msgs::ImuConstPtr& imu)
+{
+  Event e;
+  e.type = type;
+  e.has_odo = static_cast<bool>(odo);
+  e.has_imu = static_cast<bool>(imu);
+
+  if(odo){
+    MsgConversions::fromMsg(*odo, e.odo);
+  }
+  if(imu){
+    MsgConversions::fromMsg(*imu, e.imu);
+  }
+
+  if(odo && imu){
+    e.stamp = (e.imu.stamp + e.odo.stamp)/2.0;
+  }else if(odo){
+    e.stamp = e.odo.stamp;
+  }else{
+    e.stamp = e.imu.stamp;
+  }
+
+  events.push_back(e);
+}
+
+bool loadEvents(const std::string& bag_file, const Config& config,
+                std::vector<Event>& events)
+{
+  const std::string pred_odo_topic = absTopic(config.pred_odo_topic);
+  const std::string pred_imu_topic = absTopic(config.pred_imu_topic);
+  const std::string corr_odo_topic = absTopic(config.corr_odo_topic);
+  const std::string corr_imu_topic = absTopic(config.corr_imu_topic);
+
+  const bool pred_sync = !pred_odo_topic.empty() && !pred_imu_topic.empty();
+  const bool corr_sync = !corr_odo_topic.empty() && !corr_imu_topic.empty();
+
+  // message filters are fed manually (no subscribers)
+  SyncPolicy pred_policy(config.queue_size);
+  setupPolicy(pred_policy, config.pred_age_penalty, config.pred_max_time_between_imu_odo,
+              config.pred_odo_topic_rate, config.pred_imu_topic_rate);
+  message_filters::Synchronizer<SyncPolicy> pred_synchronizer(pred_policy);
+  pred_synchronizer.registerCallback(boost::bind(&addEvent, boost::ref(events), Event::PREDICTION, _1, _2));
+
+  SyncPolicy corr_policy(config.queue_size);
+  setupPolicy(corr_policy, config.corr_age_penalty, config.corr_max_time_between_imu_odo,
+              config.corr_odo_topic_rate, config.corr_imu_topic_rate);
+  message_filters::Synchronizer<SyncPolicy> corr_synchronizer(corr_policy);
+  corr_synchronizer.registerCallback(boost::bind(&addEvent, boost::ref(events), Event::CORRECTION, _1, _2));
+
+  // open bag
+  rosbag::Bag bag;
+  try{
+    bag.open(bag_file, rosbag::bagmode::Read);
+  }catch(const rosbag::BagException& e){
+    ROS_ERROR_STREAM("Unable to open bag " << bag_file << ": " << e.what());
+    return false;
+  }
+
+  std::vector<std::string> topics;
+  for(const std::string& t : {pred_odo_topic, pred_imu_topic, corr_odo_topic, corr_imu_topic}){
+    if(!t.empty()){
+      topics.push_back(t);
+    }
+  }
+
+  rosbag::View view(bag, rosbag::TopicQuery(topics));
+
+  for(const rosbag::MessageInstance& m : view)
+  {
+    const std::string& topic = m.getTopic();
+    nav_msgs::OdometryConstPtr odo = m.instantiate<nav_msgs::Odometry>();
+    sensor_msgs::ImuConstPtr   imu = m.instantiate<sensor_msgs::Imu>();
+
+    // PREDICTION
+    if(odo && topic == pred_odo_topic){
+      if(pred_sync){
+        pred_synchronizer.add<0>(odo);
+      }else{
+        addEvent(events, Event::PREDICTION, odo, NULL);
+      }
+    }
+    if(imu && topic == pred_imu_topic){
+      if(pred_sync){
+        pred_synchronizer.add<1>(imu);
+      }else{
+        addEvent(events, Event::PREDICTION, NULL, imu);
+      }
+    }
+
+    // CORRECTION
+    if(odo && topic == corr_odo_topic){
+      if(corr_sync){
+        corr_synchronizer.add<0>(odo);
+      }else{
+        addEvent(events, Event::CORRECTION, odo, NULL);
+      }
+    }
+    if(imu && topic == corr_imu_topic){
+      if(corr_sync){
+        corr_synchronizer.add<1>(imu);
+      }else{
+        addEvent(events, Event::CORRECTION, NULL, imu);
+      }
+    }
+  }
+
+  bag.close();
+  return true;
+}
+
+} // namespace Replay
@@ -0,0 +1,38 @@
+#include "drive_ros_localize_odom_fusion/replay_events.h"
+
+// the event loop is ROS independent (part of the filter core library)
+
+namespace Replay {
+
+size_t run(BaseWrapper& model, const std::vector<Event>& events,
+           const OutputCallback& output)
+{
+  size_t predictions = 0;
+
+  FilterOutput out;
+
+  for(const Event& e : events)
+  {
+    const OdoData* odo = e.has_odo ? &e.odo : NULL;
+    const ImuData* imu = e.has_imu ? &e.imu : NULL;
+
+    if(Event::PREDICTION == e.type)
+    {
+      if(model.processPredictionData(e.stamp, odo, imu, out))
+      {
+        predictions++;
+        if(output){
+          output(out);
+        }
+      }
+    }
+    else
+    {
+      model.processCorrectionData(e.stamp, odo, imu);
+    }
+  }
+
+  return predictions;
+}
+
+} // namespace Replay
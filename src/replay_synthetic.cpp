@@ -0,0 +1,232 @@
+#include "drive_ros_localize_odom_fusion/replay_synthetic.h"
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+
+// system
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace Replay {
+
+namespace {
+
+const double PRED_RATE   = 100;
+const int    CORR_STRIDE = 5;       // correction every 5th prediction (20 Hz)
+const double DURATION    = 10;      // [s]
+const double START       = 1000;    // first stamp [s]
+
+// same numbers on every platform (std::normal_distribution is implementation defined)
+class Noise
+{
+public:
+
+  explicit Noise(uint64_t seed): s(seed) {}
+
+  // xorshift64*, uniform in (0, 1)
+  double uniform()
+  {
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+    return ((s * 2685821657736338717ULL >> 11) + 0.5) * (1.0/9007199254740992.0);
+  }
+
+  // Box-Muller
+  double normal(const double sigma)
+  {
+    const double u1 = uniform();
+    const double u2 = uniform();
+    return sigma * std::sqrt(-2*std::log(u1)) * std::cos(2*M_PI*u2);
+  }
+
+private:
+  uint64_t s;
+};
+
+// driving profile at time t since the start
+struct Profile
+{
+  double v0    = 2;       // initial velocity [m/s]
+  double gap   = 0;       // stamp gap at the middle of the sequence [s]
+
+  double (*omega)(double) = NULL;   // yaw rate [rad/s]
+  double (*acc)(double)   = NULL;   // acceleration [m/s^2]
+};
+
+double zero(double)          { return 0; }
+double constTurn(double)     { return 0.4; }
+double slightTurn(double)    { return 0.1; }
+double slalomTurn(double t)  { return 0.6*std::sin(2*M_PI*0.25*t); }
+double slalomAcc(double t)   { return 0.5*std::sin(2*M_PI*0.1*t); }
+double stopAndGoAcc(double t){ return (t >= 2 && t < 4) ? -1 : ((t >= 6 && t < 8) ? 1 : 0); }
+
+bool profile(const std::string& name, Profile& p)
+{
+  p.omega = zero;
+  p.acc   = zero;
+
+  if("straight" == name)
+  {
+  }
+  else if("circle" == name)
+  {
+    p.omega = constTurn;
+  }
+  else if("slalom" == name)
+  {
+    p.v0    = 3;
+    p.omega = slalomTurn;
+    p.acc   = slalomAcc;
+  }
+  else if("stop_and_go" == name)
+  {
+    p.omega = slightTurn;
+    p.acc   = stopAndGoAcc;
+  }
+  else if("time_jump" == name)
+  {
+    p.omega = constTurn;
+    p.gap   = 1;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+const std::vector<std::string>& syntheticNames()
+{
+  static const std::vector<std::string> names =
+    { "straight", "circle", "slalom", "stop_and_go", "time_jump" };
+  return names;
+}
+
+bool syntheticEvents(const std::string& name, std::vector<Event>& events)
+{
+  Profile p;
+  if(!profile(name, p))
+    return false;
+
+  Noise noise(0x5eed + name.size());
+  events.clear();
+
+  const double dt = 1/PRED_RATE;
+  const int steps = DURATION*PRED_RATE;
+
+  // true pose and velocity, drift of the correction odometry
+  double x = 0, y = 0, theta = 0, v = p.v0;
+  double drift_x = 0, drift_y = 0, drift_theta = 0;
+  int corrections = 0;
+
+  for(int k = 1; k <= steps; k++)
+  {
+    const double t     = k*dt;
+    const double stamp = START + t + ((k > steps/2) ? p.gap : 0);
+    const double omega = p.omega(t);
+    const double a     = (v > 0 || p.acc(t) > 0) ? p.acc(t) : 0;
+
+    x     += v*dt*std::cos(theta);
+    y     += v*dt*std::sin(theta);
+    theta += omega*dt;
+    v      = std::max(0.0, v + a*dt);
+
+    // prediction: odometry twist and IMU
+    Event pred;
+    pred.type    = Event::PREDICTION;
+    pred.stamp   = stamp;
+    pred.has_odo = true;
+    pred.has_imu = true;
+    pred.odo.stamp                 = stamp;
+    pred.odo.linear_velocity_x     = v + noise.normal(0.05);
+    pred.imu.stamp                 = stamp;
+    pred.imu.angular_velocity_z    = omega + noise.normal(0.01);
+    pred.imu.linear_acceleration_x = a + noise.normal(0.05);
+    events.push_back(pred);
+
+    if(0 != k % CORR_STRIDE)
+      continue;
+
+    // correction: drifting odometry pose with growing covariance
+    drift_x     += noise.normal(0.005);
+    drift_y     += noise.normal(0.005);
+    drift_theta += noise.normal(0.0005);
+    corrections++;
+
+    Event corr;
+    corr.type    = Event::CORRECTION;
+    corr.stamp   = stamp;
+    corr.has_odo = true;
+    corr.has_imu = false;
+    corr.odo.stamp         = stamp;
+    corr.odo.position_x    = x + drift_x;
+    corr.odo.position_y    = y + drift_y;
+    corr.odo.orientation_z = std::sin(0.5*(theta + drift_theta));
+    corr.odo.orientation_w = std::cos(0.5*(theta + drift_theta));
+    corr.odo.pose_covariance[CovElem::lin_ang::linX_linX] = corrections*0.0004;
+    corr.odo.pose_covariance[CovElem::lin_ang::linY_linY] = corrections*0.0004;
+    corr.odo.pose_covariance[CovElem::lin_ang::angZ_angZ] = corrections*0.0001;
+    events.push_back(corr);
+  }
+
+  return true;
+}
+
+void compareGolden(const std::vector<FilterOutput>& trajectory,
+                   const TrajectoryColumns& golden, GoldenDiff& diff)
+{
+  diff = GoldenDiff();
+  diff.rows_match = (trajectory.size() == golden.size());
+
+  FilterOutput g;
+  const size_t rows = std::min(trajectory.size(), golden.size());
+  for(size_t i = 0; i < rows; i++)
+  {
+    const FilterOutput& o = trajectory[i];
+    golden.row(i, g);
+
+    if(std::abs(o.stamp - g.stamp) > 1e-6)
+    {
+      diff.rows_match = false;
+    }
+
+    diff.position = std::max(diff.position, std::hypot(o.x - g.x, o.y - g.y));
+    diff.theta    = std::max(diff.theta, std::abs(o.theta - g.theta));
+    for(int k = 0; k < 9; k++)
+    {
+      diff.covariance = std::max(diff.covariance, std::abs(o.covariance[k] - g.covariance[k]));
+    }
+  }
+}
+
+bool withinTolerance(const GoldenDiff& diff, const GoldenTolerance& tolerance)
+{
+  return diff.rows_match &&
+         diff.position   <= tolerance.position &&
+         diff.theta      <= tolerance.theta &&
+         diff.covariance <= tolerance.covariance;
+}
+
+std::unique_ptr<BaseWrapper> regressionModel(const std::string& model_name)
+{
+  std::unique_ptr<BaseWrapper> model(ModelRegistry::create(model_name));
+  if(!model)
+    return model;
+
+  KalmanCov cov;
+  cov.filter_init_var_x     = 0.01;
+  cov.filter_init_var_y     = 0.01;
+  cov.filter_init_var_theta = 0.01;
+  cov.sys_var_x             = 1e-4;
+  cov.sys_var_y             = 1e-4;
+  cov.sys_var_theta         = 1e-5;
+
+  model->setKalmanCov(cov);
+  model->setTimeThreshold(0.5);
+  model->reset();
+  return model;
+}
+
+} // namespace Replay
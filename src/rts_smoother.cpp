@@ -0,0 +1,185 @@
+#include "drive_ros_localize_odom_fusion/rts_smoother.h"
+
+// system
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <Eigen/Dense>
+
+typedef Eigen::Matrix3d Mat;
+typedef Eigen::Vector3d Vec;
+
+// symmetric covariance from/to the upper triangle
+static void pack(const double P[9], double packed[6])
+{
+  packed[0] = P[0];
+  packed[1] = 0.5*(P[1] + P[3]);
+  packed[2] = 0.5*(P[2] + P[6]);
+  packed[3] = P[4];
+  packed[4] = 0.5*(P[5] + P[7]);
+  packed[5] = P[8];
+}
+
+static Mat unpack(const double p[6])
+{
+  Mat P;
+  P << p[0], p[1], p[2],
+       p[1], p[3], p[4],
+       p[2], p[4], p[5];
+  return P;
+}
+
+static void toOutput(const double stamp, const Vec& x, const Mat& P, FilterOutput& out)
+{
+  out.stamp = stamp;
+  out.x     = x(0);
+  out.y     = x(1);
+  out.theta = x(2);
+  for(int r = 0; r < 3; r++)
+    for(int c = 0; c < 3; c++)
+      out.covariance[r*3 + c] = P(r, c);
+}
+
+void RtsSmoother::clear()
+{
+  steps.clear();
+  chain_start = true;
+}
+
+void RtsSmoother::reserve(const size_t n)
+{
+  steps.reserve(n);
+}
+
+void RtsSmoother::addPrediction(const double stamp, const double x[3], const double P[9],
+                                const double F_x_theta, const double F_y_theta)
+{
+  Step s;
+  s.stamp       = stamp;
+  s.chain_start = chain_start;
+  s.F_x_theta   = F_x_theta;
+  s.F_y_theta   = F_y_theta;
+  std::copy(x, x + 3, s.x_p);
+  pack(P, s.P_p);
+
+  // filtered = predicted until a correction
+  std::copy(s.x_p, s.x_p + 3, s.x_f);
+  std::copy(s.P_p, s.P_p + 6, s.P_f);
+
+  steps.push_back(s);
+  chain_start = false;
+}
+
+void RtsSmoother::addCorrection(const double x[3], const double P[9])
+{
+  if(steps.empty() || chain_start)
+    return;
+
+  Step& s = steps.back();
+  std::copy(x, x + 3, s.x_f);
+  pack(P, s.P_f);
+}
+
+void RtsSmoother::startChain()
+{
+  chain_start = true;
+}
+
+void RtsSmoother::smoothRange(const size_t begin, const size_t end, const size_t start,
+                              FilterOutput* out) const
+{
+  // newest step: smoothed = filtered
+  Vec x_s = Eigen::Map<const Vec>(steps[start].x_f);
+  Mat P_s = unpack(steps[start].P_f);
+  if(start < end)
+  {
+    toOutput(steps[start].stamp, x_s, P_s, out[start]);
+  }
+
+  for(size_t k = start; k-- > begin; )
+  {
+    const Step& s    = steps[k];
+    const Step& next = steps[k + 1];
+
+    const Vec x_f = Eigen::Map<const Vec>(s.x_f);
+    const Mat P_f = unpack(s.P_f);
+
+    // end of a chain (or a singular prediction): nothing to smooth with
+    Mat P_p_inv;
+    bool invertible = false;
+    const Mat P_p = unpack(next.P_p);
+    if(!next.chain_start)
+    {
+      double det;
+      P_p.computeInverseAndDetWithCheck(P_p_inv, det, invertible, 0.0);
+    }
+
+    if(!invertible)
+    {
+      x_s = x_f;
+      P_s = P_f;
+    }
+    else
+    {
+      Mat F = Mat::Identity();
+      F(0, 2) = next.F_x_theta;
+      F(1, 2) = next.F_y_theta;
+
+      const Mat C = P_f * F.transpose() * P_p_inv;
+      x_s = x_f + C * (x_s - Eigen::Map<const Vec>(next.x_p));
+      P_s = P_f + C * (P_s - P_p) * C.transpose();
+    }
+
+    if(k < end)
+    {
+      toOutput(s.stamp, x_s, P_s, out[k]);
+    }
+  }
+}
+
+void RtsSmoother::smooth(std::vector<FilterOutput>& out, const size_t chunk,
+                         const size_t overlap, size_t threads) const
+{
+  const size_t n = steps.size();
+  out.resize(n);
+  if(0 == n)
+    return;
+
+  // one exact pass
+  if(0 == chunk || chunk >= n)
+  {
+    smoothRange(0, n, n - 1, out.data());
+    return;
+  }
+
+  // chunks [c*chunk, (c+1)*chunk) from a worker pool
+  const size_t chunks = (n + chunk - 1)/chunk;
+  if(0 == threads)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, chunks);
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]()
+  {
+    for(size_t c = next.fetch_add(1); c < chunks; c = next.fetch_add(1))
+    {
+      const size_t begin = c*chunk;
+      const size_t end   = std::min(begin + chunk, n);
+      const size_t start = std::min(end + overlap, n) - 1;
+      smoothRange(begin, end, start, out.data());
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(size_t i = 1; i < threads; i++)
+  {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for(std::thread& t : pool)
+  {
+    t.join();
+  }
+}
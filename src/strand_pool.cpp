@@ -0,0 +1,186 @@
+#include "drive_ros_localize_odom_fusion/strand_pool.h"
+
+// system
+#include <algorithm>
+
+// worker of the calling thread (strands posted from a task stay at that worker)
+static thread_local const StrandPool* current_pool = NULL;
+static thread_local size_t current_worker = 0;
+
+void StrandPool::Strand::post(const Task& task)
+{
+  bool schedule;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(task);
+    schedule = !scheduled;
+    scheduled = true;
+  }
+
+  if(schedule)
+  {
+    pool->schedule(shared_from_this());
+  }
+}
+
+size_t StrandPool::Strand::pending()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return tasks.size();
+}
+
+StrandPool::StrandPool(size_t threads)
+{
+  if(0 == threads)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for(size_t i = 0; i < threads; i++)
+  {
+    workers.emplace_back(new Worker);
+  }
+}
+
+StrandPool::~StrandPool()
+{
+  stop();
+}
+
+StrandPool::StrandPtr StrandPool::createStrand()
+{
+  return StrandPtr(new Strand(this));
+}
+
+void StrandPool::start()
+{
+  if(running.exchange(true))
+    return;
+
+  for(size_t i = 0; i < workers.size(); i++)
+  {
+    workers[i]->thread = std::thread(&StrandPool::run, this, i);
+  }
+}
+
+void StrandPool::stop()
+{
+  if(!running.exchange(false))
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    idle_cv.notify_all();
+  }
+
+  for(std::unique_ptr<Worker>& w : workers)
+  {
+    w->thread.join();
+  }
+}
+
+void StrandPool::schedule(const StrandPtr& strand)
+{
+  const size_t index = (this == current_pool) ?
+        current_worker : next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+  {
+    std::lock_guard<std::mutex> lock(workers[index]->mutex);
+    workers[index]->strands.push_back(strand);
+  }
+
+  // pairs with the wait in run(): either the worker sees the queued strand
+  // or we see that it is sleeping and wake it up
+  queued.fetch_add(1);
+  if(sleeping.load() > 0)
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    idle_cv.notify_one();
+  }
+}
+
+bool StrandPool::take(const size_t index, StrandPtr& strand)
+{
+  // own strands, newest first
+  {
+    Worker& own = *workers[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if(!own.strands.empty())
+    {
+      strand = std::move(own.strands.back());
+      own.strands.pop_back();
+      return true;
+    }
+  }
+
+  // steal the oldest strand of another worker
+  for(size_t i = 1; i < workers.size(); i++)
+  {
+    Worker& other = *workers[(index + i) % workers.size()];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if(!other.strands.empty())
+    {
+      strand = std::move(other.strands.front());
+      other.strands.pop_front();
+      steals.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void StrandPool::runStrand(const StrandPtr& strand)
+{
+  Task task;
+  for(int i = 0; i < BATCH; i++)
+  {
+    {
+      std::lock_guard<std::mutex> lock(strand->mutex);
+      if(strand->tasks.empty())
+      {
+        strand->scheduled = false;
+        return;
+      }
+      task = std::move(strand->tasks.front());
+      strand->tasks.pop_front();
+    }
+    task();
+  }
+
+  // batch used up, give the other strands of this worker a turn
+  {
+    std::lock_guard<std::mutex> lock(strand->mutex);
+    if(strand->tasks.empty())
+    {
+      strand->scheduled = false;
+      return;
+    }
+  }
+  schedule(strand);
+}
+
+void StrandPool::run(const size_t index)
+{
+  current_pool   = this;
+  current_worker = index;
+
+  StrandPtr strand;
+  while(running.load())
+  {
+    if(take(index, strand))
+    {
+      queued.fetch_sub(1);
+      runStrand(strand);
+      strand.reset();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(idle_mutex);
+    sleeping.fetch_add(1);
+    idle_cv.wait(lock, [this]{ return queued.load() > 0 || !running.load(); });
+    sleeping.fetch_sub(1);
+  }
+
+  current_pool = NULL;
+}
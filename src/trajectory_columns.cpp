@@ -0,0 +1,210 @@
+#include "drive_ros_localize_odom_fusion/trajectory_columns.h"
+#include "drive_ros_localize_odom_fusion/fusion_log.h"
+
+// system
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char     MAGIC[8]    = "ODOMCOL";
+const uint32_t VERSION     = 1;
+const uint64_t DATA_OFFSET = 4096;
+
+static_assert(sizeof(TrajectoryColumns::Header) <= DATA_OFFSET, "header too large");
+
+const char* COLUMN_NAMES[TrajectoryColumns::COLUMNS] = {
+  "stamp", "x", "y", "theta",
+  "cov_x_x",     "cov_x_y",     "cov_x_theta",
+  "cov_y_x",     "cov_y_y",     "cov_y_theta",
+  "cov_theta_x", "cov_theta_y", "cov_theta_theta" };
+
+// value of one column
+double value(const FilterOutput& out, const int c)
+{
+  switch(c)
+  {
+    case TrajectoryColumns::STAMP: return out.stamp;
+    case TrajectoryColumns::X:     return out.x;
+    case TrajectoryColumns::Y:     return out.y;
+    case TrajectoryColumns::THETA: return out.theta;
+    default:                       return out.covariance[c - TrajectoryColumns::COV_X_X];
+  }
+}
+
+} // namespace
+
+TrajectoryColumns::TrajectoryColumns():
+  map(NULL), map_size(0), rows(0), data(NULL), index(NULL), index_stride(1), index_size(0)
+{
+}
+
+TrajectoryColumns::~TrajectoryColumns()
+{
+  close();
+}
+
+bool TrajectoryColumns::write(const std::string& filename, const std::vector<FilterOutput>& trajectory,
+                              const size_t stride)
+{
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if(!file)
+  {
+    FUSION_ERROR_STREAM("Opening " << filename << " failed.");
+    return false;
+  }
+
+  const uint64_t n = trajectory.size();
+
+  // header (padded to the data offset)
+  std::vector<char> head(DATA_OFFSET, 0);
+  Header& header = *reinterpret_cast<Header*>(head.data());
+  std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.version      = VERSION;
+  header.columns      = COLUMNS;
+  header.rows         = n;
+  header.data_offset  = DATA_OFFSET;
+  header.index_offset = DATA_OFFSET + COLUMNS*n*sizeof(double);
+  header.index_stride = std::max<size_t>(stride, 1);
+  header.index_size   = (n + header.index_stride - 1) / header.index_stride;
+  for(int c = 0; c < COLUMNS; c++)
+  {
+    std::strncpy(header.column_names[c], COLUMN_NAMES[c], sizeof(header.column_names[c]) - 1);
+  }
+  file.write(head.data(), head.size());
+
+  // columns
+  std::vector<double> column(n);
+  for(int c = 0; c < COLUMNS; c++)
+  {
+    for(size_t i = 0; i < n; i++)
+      column[i] = value(trajectory[i], c);
+
+    file.write(reinterpret_cast<const char*>(column.data()), n*sizeof(double));
+  }
+
+  // index
+  for(size_t i = 0; i < n; i += header.index_stride)
+  {
+    file.write(reinterpret_cast<const char*>(&trajectory[i].stamp), sizeof(double));
+  }
+
+  if(!file)
+  {
+    FUSION_ERROR_STREAM("Writing " << filename << " failed.");
+    return false;
+  }
+  return true;
+}
+
+bool TrajectoryColumns::open(const std::string& filename)
+{
+  close();
+
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0)
+  {
+    FUSION_ERROR_STREAM("Opening " << filename << " failed: " << std::strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if(0 != fstat(fd, &st) || st.st_size < static_cast<off_t>(DATA_OFFSET))
+  {
+    FUSION_ERROR_STREAM(filename << " is not a trajectory column file.");
+    ::close(fd);
+    return false;
+  }
+
+  map_size = st.st_size;
+  map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if(MAP_FAILED == map)
+  {
+    FUSION_ERROR_STREAM("Mapping " << filename << " failed: " << std::strerror(errno));
+    map = NULL;
+    return false;
+  }
+
+  // check header and sizes
+  const Header& header = *static_cast<const Header*>(map);
+  if(0 != std::memcmp(header.magic, MAGIC, sizeof(header.magic)) ||
+     VERSION != header.version || COLUMNS != header.columns ||
+     0 == header.index_stride ||
+     header.index_offset != header.data_offset + COLUMNS*header.rows*sizeof(double) ||
+     header.index_offset + header.index_size*sizeof(double) > map_size)
+  {
+    FUSION_ERROR_STREAM(filename << " is not a trajectory column file (version " << VERSION << ").");
+    close();
+    return false;
+  }
+
+  const char* base = static_cast<const char*>(map);
+  rows         = header.rows;
+  data         = reinterpret_cast<const double*>(base + header.data_offset);
+  index        = reinterpret_cast<const double*>(base + header.index_offset);
+  index_stride = header.index_stride;
+  index_size   = header.index_size;
+  return true;
+}
+
+void TrajectoryColumns::close()
+{
+  if(map)
+  {
+    munmap(map, map_size);
+  }
+
+  map      = NULL;
+  map_size = 0;
+  rows     = 0;
+  data     = NULL;
+  index    = NULL;
+}
+
+void TrajectoryColumns::row(const size_t i, FilterOutput& out) const
+{
+  out.stamp = data[STAMP*rows + i];
+  out.x     = data[X*rows + i];
+  out.y     = data[Y*rows + i];
+  out.theta = data[THETA*rows + i];
+
+  for(int k = 0; k < 9; k++)
+    out.covariance[k] = data[(COV_X_X + k)*rows + i];
+}
+
+bool TrajectoryColumns::last(FilterOutput& out) const
+{
+  if(0 == rows)
+    return false;
+
+  row(rows - 1, out);
+  return true;
+}
+
+size_t TrajectoryColumns::lowerBound(const double t) const
+{
+  // index entry k holds the stamp of row k*index_stride
+  const size_t k = std::lower_bound(index, index + index_size, t) - index;
+
+  // the row lies between the previous and this index entry
+  const size_t first = (k > 0) ? (k - 1)*index_stride : 0;
+  const size_t last  = std::min(k*index_stride + 1, rows);
+
+  const double* stamps = column(STAMP);
+  return std::lower_bound(stamps + first, stamps + last, t) - stamps;
+}
+
+void TrajectoryColumns::window(const double begin_stamp, const double end_stamp,
+                               size_t& begin, size_t& end) const
+{
+  begin = lowerBound(begin_stamp);
+  end   = std::max(begin, lowerBound(end_stamp));
+}
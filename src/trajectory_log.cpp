@@ -0,0 +1,211 @@
+#include "drive_ros_localize_odom_fusion/trajectory_log.h"
+#include "drive_ros_localize_odom_fusion/fusion_log.h"
+
+// system
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char     MAGIC[8] = "ODOMLOG";
+const uint32_t VERSION  = 1;
+
+// records are written as they are in memory
+static_assert(sizeof(FilterOutput) == 13*sizeof(double), "unexpected FilterOutput layout");
+
+struct Header
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t record_size;
+};
+
+// write all bytes (write may write less than requested)
+bool writeAll(int fd, const void* data, size_t size)
+{
+  const char* p = static_cast<const char*>(data);
+  while(size > 0)
+  {
+    const ssize_t n = ::write(fd, p, size);
+    if(n < 0)
+    {
+      // interrupted by a signal before anything was written
+      if(errno == EINTR)
+        continue;
+      return false;
+    }
+
+    p    += n;
+    size -= n;
+  }
+  return true;
+}
+
+} // namespace
+
+TrajectoryLog::TrajectoryLog():
+  queue(NULL), wait_for_space(false), fd(-1)
+{
+}
+
+TrajectoryLog::~TrajectoryLog()
+{
+  close();
+}
+
+bool TrajectoryLog::open(const std::string& filename, size_t ring_size, bool wait)
+{
+  close();
+
+  fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0)
+  {
+    FUSION_ERROR_STREAM("Opening trajectory log " << filename << " failed: " << std::strerror(errno));
+    return false;
+  }
+
+  Header header;
+  std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.version     = VERSION;
+  header.record_size = sizeof(FilterOutput);
+  if(!writeAll(fd, &header, sizeof(header)))
+  {
+    FUSION_ERROR_STREAM("Writing trajectory log header to " << filename << " failed: " << std::strerror(errno));
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+
+  // all memory is allocated here, log() and the writer do not allocate
+  queue = new SpscQueue<FilterOutput>(ring_size);
+  batch.resize(queue->capacity());
+  dropped_records = 0;
+  wait_for_space = wait;
+
+  running = true;
+  thread = std::thread(&TrajectoryLog::run, this);
+  return true;
+}
+
+void TrajectoryLog::close()
+{
+  if(running.exchange(false))
+  {
+    thread.join();
+  }
+
+  if(fd >= 0)
+  {
+    ::close(fd);
+    fd = -1;
+
+    if(dropped_records > 0)
+    {
+      FUSION_WARN_STREAM("Trajectory log dropped " << dropped_records << " records.");
+    }
+  }
+
+  delete queue;
+  queue = NULL;
+}
+
+bool TrajectoryLog::log(const FilterOutput& out)
+{
+  if(NULL == queue)
+  {
+    return false;
+  }
+
+  while(!queue->push(out))
+  {
+    if(!wait_for_space)
+    {
+      dropped_records.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+size_t TrajectoryLog::flush()
+{
+  size_t n = 0;
+  FilterOutput* out;
+  while(n < batch.size() && NULL != (out = queue->front()))
+  {
+    batch[n++] = *out;
+    queue->pop();
+  }
+
+  if(n > 0 && !writeAll(fd, batch.data(), n*sizeof(FilterOutput)))
+  {
+    FUSION_ERROR_STREAM("Writing trajectory log failed: " << std::strerror(errno));
+  }
+  return n;
+}
+
+void TrajectoryLog::run()
+{
+  while(running.load(std::memory_order_relaxed))
+  {
+    // collect records for a while instead of writing each one
+    if(0 == flush())
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  // write the rest
+  while(flush() > 0);
+}
+
+bool TrajectoryLog::read(const std::string& filename, std::vector<FilterOutput>& records)
+{
+  const int in = ::open(filename.c_str(), O_RDONLY);
+  if(in < 0)
+  {
+    FUSION_ERROR_STREAM("Opening trajectory log " << filename << " failed: " << std::strerror(errno));
+    return false;
+  }
+
+  Header header;
+  if(static_cast<ssize_t>(sizeof(header)) != ::read(in, &header, sizeof(header)) ||
+     0 != std::memcmp(header.magic, MAGIC, sizeof(header.magic)) ||
+     VERSION != header.version ||
+     sizeof(FilterOutput) != header.record_size)
+  {
+    FUSION_ERROR_STREAM(filename << " is not a trajectory log (version " << VERSION << ").");
+    ::close(in);
+    return false;
+  }
+
+  // read records in chunks
+  records.clear();
+  std::vector<FilterOutput> chunk(1024);
+  ssize_t n;
+  size_t rest = 0;
+  while((n = ::read(in, reinterpret_cast<char*>(chunk.data()) + rest,
+                    chunk.size()*sizeof(FilterOutput) - rest)) > 0)
+  {
+    rest += n;
+    const size_t complete = rest / sizeof(FilterOutput);
+    records.insert(records.end(), chunk.begin(), chunk.begin() + complete);
+
+    // keep an incomplete record for the next read
+    rest -= complete*sizeof(FilterOutput);
+    std::memmove(chunk.data(), chunk.data() + complete, rest);
+  }
+
+  ::close(in);
+
+  if(rest > 0)
+  {
+    FUSION_WARN_STREAM(filename << " ends with an incomplete record.");
+  }
+  return true;
+}
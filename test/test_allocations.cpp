@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+// system
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// filter core
+#include "drive_ros_localize_odom_fusion/CTRA_wrapper.h"
+#include "drive_ros_localize_odom_fusion/CTRV_wrapper.h"
+#include "drive_ros_localize_odom_fusion/imu_preintegration.h"
+#include "drive_ros_localize_odom_fusion/latency_stats.h"
+#include "drive_ros_localize_odom_fusion/message_pool.h"
+#include "drive_ros_localize_odom_fusion/output_scheduler.h"
+
+/*
+ * The steady state of the pipeline must not allocate: pre-integration, output
+ * schedule, wrapper steps (with history and late samples), latency stats,
+ * extrapolation and pooled output messages are run after a warm-up while a
+ * replaced operator new counts the heap allocations of the process.
+ *
+ */
+
+// heap allocations of the process
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if(void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+// gcc does not know that operator new is replaced by malloc
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+// stand-in for a ROS message with strings
+struct PooledMessage
+{
+  std::string frame_id = "odometry_static_frame";
+  double pose[7] = {};
+};
+
+// allocations of steps pipeline steps after the warm-up
+template<class Wrapper>
+static size_t steadyStateAllocations(const size_t history, const int steps)
+{
+  Wrapper wrapper;
+  KalmanCov cov;
+  cov.filter_init_var_x = cov.filter_init_var_y = cov.filter_init_var_theta = 0.01;
+  cov.sys_var_x = cov.sys_var_y = cov.sys_var_theta = 0.001;
+  wrapper.setKalmanCov(cov);
+  wrapper.setTimeThreshold(0.5);
+  wrapper.setHistorySize(history);
+  wrapper.setExtrapolation(true);
+  LatencyStats latency;
+  wrapper.setLatencyStats(&latency);
+  wrapper.reset();
+
+  ImuPreintegration preintegration(0.004);
+  OutputScheduler scheduler;
+  scheduler.setRates(100, 50);
+  MessagePool<PooledMessage> pool(4);
+
+  FilterSample sample;
+  sample.has_odo = sample.has_imu = true;
+  sample.imu.angular_velocity_z = 0.5;
+  sample.imu.linear_acceleration_x = 0.5;
+  sample.odo.linear_velocity_x = 1.0;
+  sample.odo.pose_covariance[CovElem::lin_ang::linX_linX] = 0.01;
+  sample.odo.pose_covariance[CovElem::lin_ang::linY_linY] = 0.01;
+  sample.odo.pose_covariance[CovElem::lin_ang::angZ_angZ] = 0.01;
+
+  FilterOutput out;
+  FilterSample integrated;
+  double stamp = 1.0;
+  size_t step = 0;
+  double checksum = 0;
+
+  auto run = [&]()
+  {
+    // 1 kHz prediction samples, 100 Hz corrections (every other one late)
+    stamp += 0.001;
+    step++;
+    sample.stamp = sample.odo.stamp = sample.imu.stamp = stamp;
+    sample.odo.position_x += 0.001;
+
+    if(preintegration.add(sample, integrated))
+    {
+      const int outputs = scheduler.due(integrated.stamp);
+      if(wrapper.processPredictionData(integrated.stamp, &integrated.odo, &integrated.imu,
+                                       out, 0 != outputs) && outputs)
+      {
+        PooledMessage* msg = pool.get().get();
+        msg->pose[0] = out.x;
+        checksum += msg->pose[0];
+      }
+    }
+
+    if(0 == step % 10)
+    {
+      const double corr_stamp = (step % 20) ? stamp : stamp - 0.003;
+      wrapper.processCorrectionData(corr_stamp, &sample.odo, &sample.imu);
+      wrapper.extrapolate(stamp + 0.002, out);
+    }
+  };
+
+  // warm-up (fills the history ring)
+  for(int i = 0; i < 1000; i++)
+  {
+    run();
+  }
+
+  const size_t before = allocations.load();
+  for(int i = 0; i < steps; i++)
+  {
+    run();
+  }
+  const size_t count = allocations.load() - before;
+
+  EXPECT_TRUE(std::isfinite(checksum));
+  return count;
+}
+
+TEST(Allocations, CTRASteadyState)
+{
+  EXPECT_EQ(0u, steadyStateAllocations<CTRAWrapper>(0, 10000));
+}
+
+TEST(Allocations, CTRASteadyStateHistory)
+{
+  EXPECT_EQ(0u, steadyStateAllocations<CTRAWrapper>(32, 10000));
+}
+
+TEST(Allocations, CTRVSteadyState)
+{
+  EXPECT_EQ(0u, steadyStateAllocations<CTRVWrapper>(0, 10000));
+}
+
+TEST(Allocations, CTRVSteadyStateHistory)
+{
+  EXPECT_EQ(0u, steadyStateAllocations<CTRVWrapper>(32, 10000));
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+// system
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// filter core
+#include <kalman/ExtendedKalmanFilter.hpp>
+#include "drive_ros_localize_odom_fusion/batch_predict.h"
+#include "drive_ros_localize_odom_fusion/CTRA_system_model.h"
+#include "drive_ros_localize_odom_fusion/CTRV_system_model.h"
+
+/*
+ * BatchPredict against Kalman::ExtendedKalmanFilter::predict
+ *
+ * FILTERS filters (not a multiple of the SIMD width) with different initial
+ * yaw, some of them unwrapped far from zero, are predicted 800 times with the
+ * same control input for all filters and with one control input per filter.
+ * The yaw rates cover the straight and the turning branch and both sides of
+ * the threshold between them. The largest difference of the state and the
+ * covariance of every filter, relative to its largest value in the generic
+ * filter, has to stay below 1e-4 in float (Simd::sincos with AVX2/NEON,
+ * measured: about 2e-5) and 1e-12 in double (one lane, libm, measured: about
+ * 2e-14).
+ *
+ * Just above the threshold the CTRA turning solution is a difference of
+ * nearly equal terms scaled by 1/omega^2, both filters lose precision there
+ * and differ by up to 1e-2 in float and 2e-11 in double (measured: about
+ * 1.5e-3 and 3.5e-12).
+ *
+ */
+
+namespace {
+
+const size_t FILTERS = 19;
+const int    STEPS   = 800;
+
+// straight, turning, around the threshold of |omega| = 0.01
+const double OMEGAS[] = { 0, 1e-3, 0.0099, -0.0099, 0.0101, -0.0101, 0.4, -0.7 };
+const size_t NUM_OMEGAS = sizeof(OMEGAS)/sizeof(OMEGAS[0]);
+
+template<typename T>
+void setControl(CTRA::Control<T>& u, const double dt, const double v, const double a, const double om)
+{
+  u.dt()    = T(dt);
+  u.v()     = T(v);
+  u.a()     = T(a);
+  u.omega() = T(om);
+}
+
+template<typename T>
+void setControl(CTRV::Control<T>& u, const double dt, const double v, const double, const double om)
+{
+  u.dt() = T(dt);
+  u.v()  = T(v);
+  u.om() = T(om);
+}
+
+// control of filter i in the per filter runs
+template<class C>
+void laneControl(C& u, const size_t i)
+{
+  setControl(u, 0.01, 1.0 + 0.1*i, 0.3 - 0.05*i, OMEGAS[i % NUM_OMEGAS]);
+}
+
+struct Tolerance
+{
+  double regular;
+  double near_threshold;    // CTRA turning with 0.01 <= |omega| < 0.02
+
+  double at(const double omega) const
+  {
+    return (std::abs(omega) >= 0.01 && std::abs(omega) < 0.02) ? near_threshold : regular;
+  }
+};
+
+// largest element difference relative to the largest element of b
+template<class A, class B>
+double relativeDifference(const A& a, const B& b)
+{
+  const double scale = std::max(1e-30, static_cast<double>(b.cwiseAbs().maxCoeff()));
+  return static_cast<double>((a - b).cwiseAbs().maxCoeff())/scale;
+}
+
+template<class SystemModel>
+class BatchFixture
+{
+public:
+  typedef typename SystemModel::S S;
+  typedef typename SystemModel::C C;
+  typedef typename S::Scalar T;
+
+  BatchFixture(): batch(FILTERS), filters(FILTERS)
+  {
+    Kalman::Covariance<S> Q = Kalman::Covariance<S>::Zero();
+    Q.diagonal() << T(1e-4), T(1e-4), T(1e-5);
+    sys.setCovariance(Q);
+
+    for(size_t i = 0; i < FILTERS; i++)
+    {
+      S s;
+      s.x()     = T(0.5*i);
+      s.y()     = T(-0.25*i);
+      s.theta() = (i % 4 == 3) ? T(150.0 + i) : T(0.3*i - 2.0);
+
+      Kalman::Covariance<S> P = Kalman::Covariance<S>::Identity()*T(1e-2*(1 + 0.1*i));
+      P(0, 1) = P(1, 0) = T(1e-3);
+      P(0, 2) = P(2, 0) = T(-5e-4);
+
+      filters[i].init(s);
+      filters[i].setCovariance(P);
+      batch.set(i, s, P, Q);
+    }
+  }
+
+  // relative difference of the state and covariance of every filter (omega of filter i)
+  template<class Omega>
+  void expectClose(const Omega& omega, const Tolerance& tolerance) const
+  {
+    S s;
+    Kalman::Covariance<S> P;
+    for(size_t i = 0; i < FILTERS; i++)
+    {
+      batch.get(i, s, P);
+      const double limit = tolerance.at(omega(i));
+      EXPECT_LT(relativeDifference(s, filters[i].getState()), limit) << "filter " << i;
+      EXPECT_LT(relativeDifference(P, filters[i].getCovariance()), limit) << "filter " << i;
+    }
+  }
+
+  SystemModel sys;
+  BatchPredict::BatchState<T> batch;
+  std::vector<Kalman::ExtendedKalmanFilter<S>, Eigen::aligned_allocator<Kalman::ExtendedKalmanFilter<S>>> filters;
+};
+
+template<class SystemModel>
+void compareUniform(const Tolerance& tolerance)
+{
+  typedef typename SystemModel::C C;
+
+  for(size_t o = 0; o < NUM_OMEGAS; o++)
+  {
+    SCOPED_TRACE(OMEGAS[o]);
+    BatchFixture<SystemModel> f;
+
+    C u;
+    setControl(u, 0.01, 2.0, 0.5, OMEGAS[o]);
+    for(int k = 0; k < STEPS; k++)
+    {
+      BatchPredict::predict(f.batch, u);
+      for(auto& filter : f.filters)
+        filter.predict(f.sys, u);
+    }
+
+    f.expectClose([&](size_t){ return OMEGAS[o]; }, tolerance);
+  }
+}
+
+template<class SystemModel, class Kernel>
+void comparePerFilter(const Tolerance& tolerance)
+{
+  typedef typename SystemModel::C C;
+  typedef typename SystemModel::S::Scalar T;
+
+  BatchFixture<SystemModel> f;
+
+  BatchPredict::BatchControl<T> batch_u(f.batch.lanes());
+  std::vector<C, Eigen::aligned_allocator<C>> u(FILTERS);
+  for(size_t i = 0; i < FILTERS; i++)
+  {
+    // CTRV::Control has no acceleration, the kernel ignores it
+    laneControl(u[i], i);
+    batch_u.dt[i] = T(0.01);
+    batch_u.v[i]  = T(1.0 + 0.1*i);
+    batch_u.a[i]  = T(0.3 - 0.05*i);
+    batch_u.om[i] = T(OMEGAS[i % NUM_OMEGAS]);
+  }
+
+  for(int k = 0; k < STEPS; k++)
+  {
+    BatchPredict::predict<Kernel>(f.batch, batch_u);
+    for(size_t i = 0; i < FILTERS; i++)
+      f.filters[i].predict(f.sys, u[i]);
+  }
+
+  f.expectClose([](size_t i){ return OMEGAS[i % NUM_OMEGAS]; }, tolerance);
+}
+
+const Tolerance FLOAT  = { 1e-4, 1e-2 };
+const Tolerance DOUBLE = { 1e-12, 2e-11 };
+
+// CTRV has no acceleration term to cancel
+const Tolerance CTRV_FLOAT  = { 1e-4, 1e-4 };
+const Tolerance CTRV_DOUBLE = { 1e-12, 1e-12 };
+
+} // namespace
+
+TEST(BatchPredict, CTRAUniformFloat)
+{
+  compareUniform<CTRA::SystemModel<float>>(FLOAT);
+}
+
+TEST(BatchPredict, CTRAUniformDouble)
+{
+  compareUniform<CTRA::SystemModel<double>>(DOUBLE);
+}
+
+TEST(BatchPredict, CTRVUniformFloat)
+{
+  compareUniform<CTRV::SystemModel<float>>(CTRV_FLOAT);
+}
+
+TEST(BatchPredict, CTRVUniformDouble)
+{
+  compareUniform<CTRV::SystemModel<double>>(CTRV_DOUBLE);
+}
+
+TEST(BatchPredict, CTRAPerFilterFloat)
+{
+  comparePerFilter<CTRA::SystemModel<float>, BatchPredict::CTRAKernel>(FLOAT);
+}
+
+TEST(BatchPredict, CTRAPerFilterDouble)
+{
+  comparePerFilter<CTRA::SystemModel<double>, BatchPredict::CTRAKernel>(DOUBLE);
+}
+
+TEST(BatchPredict, CTRVPerFilterFloat)
+{
+  comparePerFilter<CTRV::SystemModel<float>, BatchPredict::CTRVKernel>(CTRV_FLOAT);
+}
+
+TEST(BatchPredict, CTRVPerFilterDouble)
+{
+  comparePerFilter<CTRV::SystemModel<double>, BatchPredict::CTRVKernel>(CTRV_DOUBLE);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+// system
+#include <cmath>
+
+// filter core
+#include "drive_ros_localize_odom_fusion/CTRA_wrapper.h"
+#include "drive_ros_localize_odom_fusion/CTRV_wrapper.h"
+#include "drive_ros_localize_odom_fusion/imu_preintegration.h"
+
+/*
+ * Prediction with pre-integrated IMU samples against one prediction per
+ * sample: 1 kHz samples over 2 s (10 ms window), no corrections. The yaw
+ * change after the first window and the covariance have to match, the
+ * process noise is added once per integrated sample. (The second prediction
+ * after a reset also covers the assumed first interval, so the yaw differs by
+ * a constant offset of the first window.)
+ *
+ */
+
+// 1 kHz prediction samples of a turning drive
+static FilterSample imuSample(const int k)
+{
+  FilterSample sample;
+  sample.stamp = sample.odo.stamp = sample.imu.stamp = 1.0 + 0.001*k;
+  sample.has_odo = sample.has_imu = true;
+  sample.imu.angular_velocity_z    = 0.3 + 0.2*std::sin(0.005*k);
+  sample.imu.linear_acceleration_x = 0.2*std::cos(0.003*k);
+  sample.odo.linear_velocity_x     = 2.0;
+  return sample;
+}
+
+template<class Wrapper>
+static void initWrapper(Wrapper& wrapper)
+{
+  KalmanCov cov;
+  cov.filter_init_var_x = cov.filter_init_var_y = cov.filter_init_var_theta = 0.01;
+  cov.sys_var_x = cov.sys_var_y = 1e-4;
+  cov.sys_var_theta = 1e-5;
+  wrapper.setKalmanCov(cov);
+  wrapper.setTimeThreshold(0.5);
+  wrapper.reset();
+}
+
+template<class Wrapper>
+static void comparePreintegration()
+{
+  Wrapper per_sample;
+  Wrapper integrated;
+  initWrapper(per_sample);
+  initWrapper(integrated);
+
+  ImuPreintegration preintegration(0.01);
+
+  FilterOutput out_sample;
+  FilterOutput out_integrated;
+  FilterSample released;
+  double theta_sample = 0;
+  double theta_integrated = 0;
+  int predictions = 0;
+  for(int k = 0; k <= 2000; k++)
+  {
+    const FilterSample sample = imuSample(k);
+    ASSERT_TRUE(per_sample.processPredictionData(sample.stamp, &sample.odo, &sample.imu, out_sample));
+
+    if(preintegration.add(sample, released))
+    {
+      ASSERT_TRUE(integrated.processPredictionData(released.stamp, &released.odo, &released.imu,
+                                                   out_integrated));
+      predictions++;
+
+      // yaw at the end of the first window
+      if(2 == predictions)
+      {
+        theta_sample     = out_sample.theta;
+        theta_integrated = out_integrated.theta;
+      }
+    }
+  }
+
+  // one prediction per window (plus the first sample)
+  EXPECT_EQ(201, predictions);
+  EXPECT_DOUBLE_EQ(out_sample.stamp, out_integrated.stamp);
+  EXPECT_NEAR(out_sample.theta - theta_sample, out_integrated.theta - theta_integrated, 1e-4);
+
+  // covariance grows as with one prediction per sample
+  double scale = 0;
+  for(int i = 0; i < 9; i++)
+  {
+    scale = std::max(scale, std::abs(out_sample.covariance[i]));
+  }
+  for(int i = 0; i < 9; i++)
+  {
+    EXPECT_NEAR(out_sample.covariance[i], out_integrated.covariance[i], 0.01*scale) << "element " << i;
+  }
+}
+
+TEST(ImuPreintegration, CTRACovariance)
+{
+  comparePreintegration<CTRAWrapper>();
+}
+
+TEST(ImuPreintegration, CTRVCovariance)
+{
+  comparePreintegration<CTRVWrapper>();
+}
@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+
+// system
+#include <cmath>
+#include <vector>
+
+// filter core
+#include "drive_ros_localize_odom_fusion/interpolating_sync.h"
+
+/*
+ * InterpolatingSync with known IMU and odometry streams in both modes
+ *
+ * The streams are linear in time, so the interpolated values are exact. The
+ * tests check the emitted stamps and values, when an anchor waits and when it
+ * is dropped (max_interval, older than the buffer, ring overflow, out of
+ * order) and the quaternion interpolation along the shorter arc.
+ *
+ */
+
+namespace {
+
+ImuData imuAt(const double t)
+{
+  ImuData imu;
+  imu.stamp                 = t;
+  imu.angular_velocity_z    = 10*t;
+  imu.linear_acceleration_x = 1 - 2*t;
+  return imu;
+}
+
+OdoData odoAt(const double t, const double yaw = 0)
+{
+  OdoData odo;
+  odo.stamp             = t;
+  odo.position_x        = 2*t;
+  odo.position_y        = -t;
+  odo.linear_velocity_x = 2;
+  odo.linear_velocity_y = 3*t;
+  odo.orientation_z     = std::sin(0.5*yaw);
+  odo.orientation_w     = std::cos(0.5*yaw);
+  odo.pose_covariance[0] = t;
+  return odo;
+}
+
+class SyncTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    sync.setCallback([this](const FilterSample& s){ out.push_back(s); });
+  }
+
+  InterpolatingSync sync;
+  std::vector<FilterSample> out;
+};
+
+} // namespace
+
+TEST_F(SyncTest, ImuInterpolatedToOdometry)
+{
+  sync.setInterpolated(InterpolatingSync::IMU);
+
+  for(int k = 0; k <= 2; k++)
+    sync.addImu(imuAt(0.01*k));
+
+  // anchor between 0.02 and the next IMU sample waits for it
+  sync.addOdo(odoAt(0.025));
+  EXPECT_TRUE(out.empty());
+
+  sync.addImu(imuAt(0.03));
+  ASSERT_EQ(1u, out.size());
+
+  const FilterSample& s = out[0];
+  EXPECT_TRUE(s.has_odo);
+  EXPECT_TRUE(s.has_imu);
+  EXPECT_EQ(0.025, s.stamp);
+  EXPECT_EQ(0.025, s.imu.stamp);
+  EXPECT_EQ(0.025, s.odo.stamp);
+  EXPECT_NEAR(0.25, s.imu.angular_velocity_z, 1e-12);
+  EXPECT_NEAR(0.95, s.imu.linear_acceleration_x, 1e-12);
+  EXPECT_EQ(odoAt(0.025).position_x, s.odo.position_x);
+
+  // anchor on a sample stamp is emitted at once with its values
+  sync.addOdo(odoAt(0.03));
+  ASSERT_EQ(2u, out.size());
+  EXPECT_EQ(0.03, out[1].stamp);
+  EXPECT_EQ(imuAt(0.03).angular_velocity_z, out[1].imu.angular_velocity_z);
+
+  EXPECT_EQ(0u, sync.dropped());
+}
+
+TEST_F(SyncTest, OdometryInterpolatedToImu)
+{
+  sync.setInterpolated(InterpolatingSync::ODO);
+
+  sync.addOdo(odoAt(0.0, 0.1));
+  sync.addOdo(odoAt(0.02, 0.3));
+  sync.addImu(imuAt(0.015));
+  ASSERT_EQ(1u, out.size());
+
+  const FilterSample& s = out[0];
+  EXPECT_EQ(0.015, s.stamp);
+  EXPECT_EQ(0.015, s.odo.stamp);
+  EXPECT_EQ(imuAt(0.015).angular_velocity_z, s.imu.angular_velocity_z);
+  EXPECT_NEAR(0.03, s.odo.position_x, 1e-12);
+  EXPECT_NEAR(-0.015, s.odo.position_y, 1e-12);
+  EXPECT_NEAR(2, s.odo.linear_velocity_x, 1e-12);
+  EXPECT_NEAR(0.045, s.odo.linear_velocity_y, 1e-12);
+
+  // covariance of the nearer sample (w = 0.75)
+  EXPECT_EQ(0.02, s.odo.pose_covariance[0]);
+
+  // normalized lerp: unit quaternion, yaw between the samples
+  const double yaw = FusionUtils::yawFromQuaternion(s.odo.orientation_x, s.odo.orientation_y,
+                                                    s.odo.orientation_z, s.odo.orientation_w);
+  EXPECT_NEAR(1, std::hypot(s.odo.orientation_z, s.odo.orientation_w), 1e-12);
+  EXPECT_GT(yaw, 0.2);
+  EXPECT_LT(yaw, 0.3);
+
+  EXPECT_EQ(0u, sync.dropped());
+}
+
+TEST_F(SyncTest, QuaternionSignFlip)
+{
+  sync.setInterpolated(InterpolatingSync::ODO);
+
+  // same rotation as yaw 0.3, but with the negated quaternion
+  OdoData hi = odoAt(0.02, 0.3);
+  hi.orientation_z = -hi.orientation_z;
+  hi.orientation_w = -hi.orientation_w;
+
+  sync.addOdo(odoAt(0.0, 0.1));
+  sync.addOdo(hi);
+  sync.addImu(imuAt(0.01));
+  ASSERT_EQ(1u, out.size());
+
+  // midway along the shorter arc, not through the opposite rotation
+  const OdoData& o = out[0].odo;
+  const double yaw = FusionUtils::yawFromQuaternion(o.orientation_x, o.orientation_y,
+                                                    o.orientation_z, o.orientation_w);
+  EXPECT_NEAR(0.2, yaw, 1e-3);
+  EXPECT_NEAR(1, std::hypot(o.orientation_z, o.orientation_w), 1e-12);
+}
+
+TEST_F(SyncTest, WaitOrDropOnMaxInterval)
+{
+  sync.setInterpolated(InterpolatingSync::IMU);
+  sync.setMaxInterval(0.1);
+
+  sync.addImu(imuAt(0.0));
+
+  // within max_interval of the newest sample: waits
+  sync.addOdo(odoAt(0.05));
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(0u, sync.dropped());
+
+  // bracket 0.0 - 0.2 is wider than max_interval
+  sync.addImu(imuAt(0.2));
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(1u, sync.dropped());
+
+  // more than max_interval after the newest sample: dropped without waiting
+  sync.addOdo(odoAt(0.35));
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(2u, sync.dropped());
+
+  // the stream continues normally
+  sync.addImu(imuAt(0.25));
+  sync.addImu(imuAt(0.3));
+  sync.addOdo(odoAt(0.36));
+  EXPECT_TRUE(out.empty());
+  sync.addImu(imuAt(0.37));
+  ASSERT_EQ(1u, out.size());
+  EXPECT_EQ(0.36, out[0].stamp);
+  EXPECT_EQ(2u, sync.dropped());
+}
+
+TEST_F(SyncTest, AnchorOlderThanBuffer)
+{
+  sync.setInterpolated(InterpolatingSync::IMU);
+
+  sync.addImu(imuAt(1.0));
+  sync.addImu(imuAt(1.01));
+  sync.addOdo(odoAt(0.5));
+
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(1u, sync.dropped());
+}
+
+TEST_F(SyncTest, RingOverflow)
+{
+  sync.setInterpolated(InterpolatingSync::IMU);
+
+  // 40 anchors without IMU: the oldest 8 do not fit the ring
+  for(int k = 0; k < 40; k++)
+    sync.addOdo(odoAt(0.001*k));
+  EXPECT_EQ(8u, sync.dropped());
+
+  // the rest are older than the first IMU sample
+  sync.addImu(imuAt(1.0));
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(40u, sync.dropped());
+
+  // interpolated samples overflowing the ring are not counted
+  for(int k = 1; k <= 40; k++)
+    sync.addImu(imuAt(1.0 + 0.01*k));
+  EXPECT_EQ(40u, sync.dropped());
+
+  // the oldest kept sample is 1.09
+  sync.addOdo(odoAt(1.075));
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(41u, sync.dropped());
+
+  sync.addOdo(odoAt(1.095));
+  ASSERT_EQ(1u, out.size());
+  EXPECT_NEAR(10*1.095, out[0].imu.angular_velocity_z, 1e-12);
+}
+
+TEST_F(SyncTest, OutOfOrderSamples)
+{
+  sync.setInterpolated(InterpolatingSync::IMU);
+
+  sync.addImu(imuAt(0.0));
+  sync.addImu(imuAt(0.02));
+
+  // out of order interpolated sample: ignored, not an anchor
+  sync.addImu(imuAt(0.01));
+  EXPECT_EQ(0u, sync.dropped());
+
+  sync.addOdo(odoAt(0.015));
+  ASSERT_EQ(1u, out.size());
+  EXPECT_NEAR(0.15, out[0].imu.angular_velocity_z, 1e-12);
+
+  // anchor not newer than the previous (already emitted) one: dropped
+  sync.addOdo(odoAt(0.015));
+  sync.addOdo(odoAt(0.005));
+  EXPECT_EQ(1u, out.size());
+  EXPECT_EQ(2u, sync.dropped());
+}
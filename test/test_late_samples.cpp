@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+// system
+#include <sstream>
+#include <string>
+#include <vector>
+
+// filter core
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/replay_events.h"
+#include "drive_ros_localize_odom_fusion/replay_synthetic.h"
+
+/*
+ * Late samples are applied at their true time by rewinding the history and
+ * re-propagating the newer steps (BaseWrapper::insertLateSample). Every
+ * correction of a synthetic sequence is delivered a few events late, the
+ * final pose and covariance must be the same as in order.
+ *
+ */
+
+namespace {
+
+const size_t HISTORY_SIZE = 64;
+const size_t DELAY        = 7;   // events, more than one prediction period of the corrections
+
+// every correction moved DELAY events later (it keeps its stamp)
+std::vector<Replay::Event> delayCorrections(const std::vector<Replay::Event>& events)
+{
+  std::vector<Replay::Event> delayed;
+  std::vector<std::pair<size_t, Replay::Event>> pending;
+
+  for(size_t i = 0; i < events.size(); i++)
+  {
+    if(Replay::Event::CORRECTION == events[i].type)
+    {
+      pending.push_back(std::make_pair(i + DELAY, events[i]));
+    }
+    else
+    {
+      delayed.push_back(events[i]);
+    }
+
+    while(!pending.empty() && pending.front().first <= i)
+    {
+      delayed.push_back(pending.front().second);
+      pending.erase(pending.begin());
+    }
+  }
+
+  for(const auto& p : pending)
+    delayed.push_back(p.second);
+
+  return delayed;
+}
+
+// run the events and predict once more with the last prediction input,
+// after all corrections are applied
+bool finalOutput(const std::string& model_name, const std::vector<Replay::Event>& events,
+                 FilterOutput& out)
+{
+  std::unique_ptr<BaseWrapper> model = Replay::regressionModel(model_name);
+  if(!model)
+    return false;
+  model->setHistorySize(HISTORY_SIZE);
+
+  Replay::run(*model, events, Replay::OutputCallback());
+
+  const Replay::Event* last = NULL;
+  for(const Replay::Event& e : events)
+  {
+    if(Replay::Event::PREDICTION == e.type && (NULL == last || e.stamp > last->stamp))
+      last = &e;
+  }
+  if(NULL == last)
+    return false;
+
+  return model->processPredictionData(last->stamp + 0.01,
+                                      last->has_odo ? &last->odo : NULL,
+                                      last->has_imu ? &last->imu : NULL, out);
+}
+
+} // namespace
+
+TEST(LateSamples, DelayedCorrectionsMatchInOrder)
+{
+  std::vector<Replay::Event> events;
+
+  std::istringstream names(ModelRegistry::names());
+  for(std::string model_name; std::getline(names, model_name, '|'); )
+  {
+    for(const std::string& sequence : Replay::syntheticNames())
+    {
+      // the reset of time_jump clears the history, corrections from before
+      // the gap are dropped when they arrive after it
+      if("time_jump" == sequence)
+        continue;
+
+      SCOPED_TRACE(model_name + " " + sequence);
+      ASSERT_TRUE(Replay::syntheticEvents(sequence, events));
+
+      const std::vector<Replay::Event> delayed = delayCorrections(events);
+      ASSERT_EQ(events.size(), delayed.size());
+
+      FilterOutput in_order, late;
+      ASSERT_TRUE(finalOutput(model_name, events, in_order));
+      ASSERT_TRUE(finalOutput(model_name, delayed, late));
+
+      // same steps in the same order, so the re-propagation is exact
+      EXPECT_EQ(in_order.stamp, late.stamp);
+      EXPECT_EQ(in_order.x,     late.x);
+      EXPECT_EQ(in_order.y,     late.y);
+      EXPECT_EQ(in_order.theta, late.theta);
+      for(int i = 0; i < 9; i++)
+      {
+        EXPECT_EQ(in_order.covariance[i], late.covariance[i]) << "element " << i;
+      }
+    }
+  }
+}
+
+TEST(LateSamples, OlderThanHistoryIsDropped)
+{
+  // expected warning about the dropped sample
+  FusionLog::setLevel(FusionLog::Off);
+
+  std::vector<Replay::Event> events;
+  ASSERT_TRUE(Replay::syntheticEvents("circle", events));
+
+  std::unique_ptr<BaseWrapper> model = Replay::regressionModel("CTRA");
+  ASSERT_TRUE(model != NULL);
+  model->setHistorySize(HISTORY_SIZE);
+
+  // first correction after more steps than the history keeps
+  size_t first_correction = 0;
+  while(Replay::Event::CORRECTION != events[first_correction].type)
+    first_correction++;
+
+  std::vector<Replay::Event> predictions;
+  for(const Replay::Event& e : events)
+  {
+    if(Replay::Event::PREDICTION == e.type)
+      predictions.push_back(e);
+    if(predictions.size() >= 2*HISTORY_SIZE)
+      break;
+  }
+  ASSERT_EQ(2*HISTORY_SIZE, predictions.size());
+  Replay::run(*model, predictions, Replay::OutputCallback());
+
+  const Replay::Event& c = events[first_correction];
+  EXPECT_FALSE(model->processCorrectionData(c.stamp, c.has_odo ? &c.odo : NULL,
+                                            c.has_imu ? &c.imu : NULL));
+
+  FusionLog::setLevel(FusionLog::Warn);
+}
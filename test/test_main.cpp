@@ -0,0 +1,12 @@
+#include <gtest/gtest.h>
+
+#include "drive_ros_localize_odom_fusion/fusion_log.h"
+
+int main(int argc, char** argv)
+{
+  // keep the filter core quiet
+  FusionLog::setLevel(FusionLog::Warn);
+
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
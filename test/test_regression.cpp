@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+// system
+#include <sstream>
+#include <string>
+#include <vector>
+
+// filter core
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/replay_events.h"
+#include "drive_ros_localize_odom_fusion/replay_synthetic.h"
+#include "drive_ros_localize_odom_fusion/trajectory_columns.h"
+
+/*
+ * Every model on every synthetic sequence against the golden trajectories
+ * in regression/golden (same runs as "replay --regression", update them with
+ * --update_golden 1 after an intended change of the filter output).
+ *
+ */
+
+#ifndef ODOM_FUSION_GOLDEN_DIR
+#define ODOM_FUSION_GOLDEN_DIR "regression/golden"
+#endif
+
+TEST(Regression, GoldenTrajectories)
+{
+  // expected resets (time_jump) are not reported
+  FusionLog::setLevel(FusionLog::Off);
+
+  std::vector<Replay::Event> events;
+  std::vector<FilterOutput> trajectory;
+
+  std::istringstream names(ModelRegistry::names());
+  for(std::string model_name; std::getline(names, model_name, '|'); )
+  {
+    for(const std::string& sequence : Replay::syntheticNames())
+    {
+      SCOPED_TRACE(model_name + " " + sequence);
+
+      ASSERT_TRUE(Replay::syntheticEvents(sequence, events));
+      std::unique_ptr<BaseWrapper> model = Replay::regressionModel(model_name);
+      ASSERT_TRUE(model != NULL);
+
+      trajectory.clear();
+      Replay::run(*model, events, [&](const FilterOutput& out){ trajectory.push_back(out); });
+
+      const std::string file = std::string(ODOM_FUSION_GOLDEN_DIR) + "/" + model_name + "_" + sequence + ".col";
+      TrajectoryColumns golden;
+      ASSERT_TRUE(golden.open(file)) << file;
+
+      Replay::GoldenDiff diff;
+      Replay::compareGolden(trajectory, golden, diff);
+      EXPECT_TRUE(Replay::withinTolerance(diff, Replay::GoldenTolerance()))
+          << "rows match " << diff.rows_match << " position " << diff.position
+          << " theta " << diff.theta << " covariance " << diff.covariance;
+    }
+  }
+
+  FusionLog::setLevel(FusionLog::Warn);
+}
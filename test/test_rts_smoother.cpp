@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+// system
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// filter core
+#include "drive_ros_localize_odom_fusion/model_registry.h"
+#include "drive_ros_localize_odom_fusion/replay_events.h"
+#include "drive_ros_localize_odom_fusion/replay_synthetic.h"
+#include "drive_ros_localize_odom_fusion/rts_smoother.h"
+
+/*
+ * RtsSmoother on the forward pass of the synthetic sequences
+ *
+ * The newest step of every chain keeps the filtered state, smoothing never
+ * increases the variances, a filter reset (time_jump) is not smoothed across
+ * and chunked smoothing stays within the documented bound of the exact pass.
+ *
+ */
+
+namespace {
+
+// forward pass of a regression model over the events
+void record(const std::string& model_name, const std::vector<Replay::Event>& events,
+            RtsSmoother& smoother)
+{
+  std::unique_ptr<BaseWrapper> model = Replay::regressionModel(model_name);
+  ASSERT_TRUE(model != NULL);
+  model->setSmoother(&smoother);
+  Replay::run(*model, events, Replay::OutputCallback());
+}
+
+// filtered state of a step as output
+FilterOutput filtered(const RtsSmoother::Step& s)
+{
+  const int upper[9] = { 0, 1, 2,
+                         1, 3, 4,
+                         2, 4, 5 };
+  FilterOutput out;
+  out.stamp = s.stamp;
+  out.x     = s.x_f[0];
+  out.y     = s.x_f[1];
+  out.theta = s.x_f[2];
+  for(int i = 0; i < 9; i++)
+    out.covariance[i] = s.P_f[upper[i]];
+  return out;
+}
+
+void expectEqual(const FilterOutput& a, const FilterOutput& b)
+{
+  EXPECT_EQ(a.stamp, b.stamp);
+  EXPECT_EQ(a.x,     b.x);
+  EXPECT_EQ(a.y,     b.y);
+  EXPECT_EQ(a.theta, b.theta);
+  for(int i = 0; i < 9; i++)
+    EXPECT_EQ(a.covariance[i], b.covariance[i]) << "element " << i;
+}
+
+// run the test for every model on every synthetic sequence
+template<class Test>
+void forAllSequences(const Test& test)
+{
+  std::vector<Replay::Event> events;
+
+  std::istringstream names(ModelRegistry::names());
+  for(std::string model_name; std::getline(names, model_name, '|'); )
+  {
+    for(const std::string& sequence : Replay::syntheticNames())
+    {
+      SCOPED_TRACE(model_name + " " + sequence);
+      ASSERT_TRUE(Replay::syntheticEvents(sequence, events));
+
+      RtsSmoother smoother;
+      record(model_name, events, smoother);
+      ASSERT_GT(smoother.size(), 0u);
+      test(smoother);
+    }
+  }
+}
+
+} // namespace
+
+TEST(RtsSmoother, ChainEndKeepsFilteredState)
+{
+  FusionLog::setLevel(FusionLog::Off);
+
+  forAllSequences([](const RtsSmoother& smoother)
+  {
+    std::vector<FilterOutput> out;
+    smoother.smooth(out);
+
+    const std::vector<RtsSmoother::Step>& steps = smoother.getSteps();
+    ASSERT_EQ(steps.size(), out.size());
+    for(size_t k = 0; k < steps.size(); k++)
+    {
+      if(k + 1 == steps.size() || steps[k + 1].chain_start)
+      {
+        SCOPED_TRACE(k);
+        expectEqual(filtered(steps[k]), out[k]);
+      }
+    }
+  });
+
+  FusionLog::setLevel(FusionLog::Warn);
+}
+
+TEST(RtsSmoother, VarianceNotIncreased)
+{
+  FusionLog::setLevel(FusionLog::Off);
+
+  forAllSequences([](const RtsSmoother& smoother)
+  {
+    std::vector<FilterOutput> out;
+    smoother.smooth(out);
+
+    const std::vector<RtsSmoother::Step>& steps = smoother.getSteps();
+    for(size_t k = 0; k < steps.size(); k++)
+    {
+      const FilterOutput f = filtered(steps[k]);
+      for(int i = 0; i < 9; i += 4)
+      {
+        // rounding of the backward pass
+        EXPECT_LE(out[k].covariance[i], f.covariance[i]*(1 + 1e-12)) << "step " << k << " element " << i;
+      }
+    }
+  });
+
+  FusionLog::setLevel(FusionLog::Warn);
+}
+
+TEST(RtsSmoother, ResetNotSmoothedAcross)
+{
+  // expected reset at the gap
+  FusionLog::setLevel(FusionLog::Off);
+
+  std::vector<Replay::Event> events;
+  ASSERT_TRUE(Replay::syntheticEvents("time_jump", events));
+
+  // events before the gap
+  size_t gap = 1;
+  while(gap < events.size() && events[gap].stamp - events[gap - 1].stamp < 0.5)
+    gap++;
+  ASSERT_LT(gap, events.size());
+  const std::vector<Replay::Event> first(events.begin(), events.begin() + gap);
+
+  RtsSmoother full, before;
+  record("CTRA", events, full);
+  record("CTRA", first, before);
+
+  const std::vector<RtsSmoother::Step>& steps = full.getSteps();
+  ASSERT_EQ(2, std::count_if(steps.begin(), steps.end(),
+                             [](const RtsSmoother::Step& s){ return s.chain_start; }));
+  ASSERT_LT(before.size(), full.size());
+
+  // the first chain is smoothed the same without the steps after the reset
+  std::vector<FilterOutput> out_full, out_before;
+  full.smooth(out_full);
+  before.smooth(out_before);
+  for(size_t k = 0; k < out_before.size(); k++)
+  {
+    SCOPED_TRACE(k);
+    expectEqual(out_before[k], out_full[k]);
+  }
+
+  FusionLog::setLevel(FusionLog::Warn);
+}
+
+TEST(RtsSmoother, ChunkedWithinBound)
+{
+  FusionLog::setLevel(FusionLog::Off);
+
+  // chunk 100, overlap and largest deviation documented in rts_smoother.h
+  struct Bound { size_t overlap; double position, theta; };
+  const Bound bounds[] = { { 50, 3e-2, 1e-2 }, { 200, 2e-3, 2e-3 } };
+
+  forAllSequences([&](const RtsSmoother& smoother)
+  {
+    std::vector<FilterOutput> exact, chunked;
+    smoother.smooth(exact);
+
+    for(const Bound& bound : bounds)
+    {
+      SCOPED_TRACE(bound.overlap);
+      smoother.smooth(chunked, 100, bound.overlap, 4);
+      ASSERT_EQ(exact.size(), chunked.size());
+
+      double position = 0, theta = 0;
+      for(size_t k = 0; k < exact.size(); k++)
+      {
+        EXPECT_EQ(exact[k].stamp, chunked[k].stamp);
+        position = std::max(position, std::hypot(exact[k].x - chunked[k].x, exact[k].y - chunked[k].y));
+        theta    = std::max(theta, std::abs(exact[k].theta - chunked[k].theta));
+      }
+
+      EXPECT_LT(position, bound.position);
+      EXPECT_LT(theta, bound.theta);
+    }
+  });
+
+  FusionLog::setLevel(FusionLog::Warn);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+// system
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// filter core
+#include "drive_ros_localize_odom_fusion/fusion_log.h"
+#include "drive_ros_localize_odom_fusion/trajectory_log.h"
+
+/*
+ * TrajectoryLog open/log/close and read round trip
+ *
+ * More records than the ring and the read chunk hold are written and read
+ * back unchanged. A trailing incomplete record is ignored, files which are
+ * not a trajectory log are rejected.
+ *
+ */
+
+namespace {
+
+const size_t RECORDS = 3000;
+
+FilterOutput record(const size_t k)
+{
+  FilterOutput out;
+  out.stamp = 0.01*k;
+  out.x     = 0.5*k;
+  out.y     = -0.25*k;
+  out.theta = 1e-3*k;
+  for(int i = 0; i < 9; i++)
+    out.covariance[i] = k + 0.1*i;
+  return out;
+}
+
+class TrajectoryLogTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    file = "/tmp/odom_fusion_test_" + std::to_string(::getpid()) + ".bin";
+  }
+
+  void TearDown() override
+  {
+    std::remove(file.c_str());
+  }
+
+  // log RECORDS records (waiting for space, so none are dropped)
+  void writeLog()
+  {
+    TrajectoryLog log;
+    ASSERT_TRUE(log.open(file, 64, true));
+    for(size_t k = 0; k < RECORDS; k++)
+      ASSERT_TRUE(log.log(record(k)));
+    log.close();
+    EXPECT_EQ(0u, log.dropped());
+  }
+
+  std::string file;
+};
+
+void expectRecords(const std::vector<FilterOutput>& records)
+{
+  ASSERT_EQ(RECORDS, records.size());
+  for(size_t k = 0; k < RECORDS; k++)
+  {
+    const FilterOutput expected = record(k);
+    ASSERT_EQ(expected.stamp, records[k].stamp) << "record " << k;
+    ASSERT_EQ(expected.x,     records[k].x) << "record " << k;
+    ASSERT_EQ(expected.y,     records[k].y) << "record " << k;
+    ASSERT_EQ(expected.theta, records[k].theta) << "record " << k;
+    for(int i = 0; i < 9; i++)
+      ASSERT_EQ(expected.covariance[i], records[k].covariance[i]) << "record " << k;
+  }
+}
+
+} // namespace
+
+TEST_F(TrajectoryLogTest, RoundTrip)
+{
+  writeLog();
+
+  std::vector<FilterOutput> records;
+  ASSERT_TRUE(TrajectoryLog::read(file, records));
+  expectRecords(records);
+}
+
+TEST_F(TrajectoryLogTest, IncompleteRecordIgnored)
+{
+  writeLog();
+  {
+    std::ofstream out(file, std::ios::binary | std::ios::app);
+    const char partial[sizeof(FilterOutput)/2] = {};
+    out.write(partial, sizeof(partial));
+  }
+
+  // expected warning about the incomplete record
+  FusionLog::setLevel(FusionLog::Off);
+  std::vector<FilterOutput> records;
+  EXPECT_TRUE(TrajectoryLog::read(file, records));
+  FusionLog::setLevel(FusionLog::Warn);
+  expectRecords(records);
+}
+
+TEST_F(TrajectoryLogTest, NotALog)
+{
+  FusionLog::setLevel(FusionLog::Off);
+  std::vector<FilterOutput> records;
+
+  // missing file
+  EXPECT_FALSE(TrajectoryLog::read(file, records));
+
+  // truncated header
+  {
+    std::ofstream out(file, std::ios::binary);
+    out << "ODOMLOG";
+  }
+  EXPECT_FALSE(TrajectoryLog::read(file, records));
+
+  // other content
+  {
+    std::ofstream out(file, std::ios::binary);
+    out << "timestamp,pose_posX,pose_posY,pose_posZ" << std::endl;
+  }
+  EXPECT_FALSE(TrajectoryLog::read(file, records));
+
+  // unwritable path
+  TrajectoryLog log;
+  EXPECT_FALSE(log.open("/nonexistent/odom_fusion_test.bin"));
+  EXPECT_FALSE(log.log(record(0)));
+  FusionLog::setLevel(FusionLog::Warn);
+}